@@ -0,0 +1,590 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <iterator>
+#include <memory>
+#include <ranges>
+#include <span>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+enum class Balancing { NONE, AVL, RED_BLACK };
+
+template <typename T>
+struct Node {
+  T data;
+  std::unique_ptr<Node<T>> left{nullptr};
+  std::unique_ptr<Node<T>> right{nullptr};
+  Node<T>* parent{nullptr};
+  size_t size{1};    // number of nodes in the subtree, for select/rank
+  int8_t height{1};  // AVL: height of the subtree rooted here
+  bool red{true};    // Red-black: color, new nodes start red
+  explicit Node(const T& value) : data(value) {}
+};
+
+// Binary search tree with an optional balancing scheme. Insert, erase,
+// search and iteration are iterative, so they neither recurse nor overflow the
+// stack on degenerate (e.g. sorted) input; with AVL or RED_BLACK balancing the
+// height stays O(log n).
+template <typename T, Balancing B = Balancing::NONE>
+class BinaryTree {
+  using NodeT = Node<T>;
+
+ public:
+  // In-order bidirectional iterator that follows parent pointers, so it needs
+  // no stack. end() is a null node; decrementing it yields the maximum.
+  class ConstIterator {
+   public:
+    using iterator_category = std::bidirectional_iterator_tag;
+    using value_type = T;
+    using difference_type = std::ptrdiff_t;
+    using pointer = const T*;
+    using reference = const T&;
+
+    ConstIterator() = default;
+
+    reference operator*() const { return node_->data; }
+    pointer operator->() const { return &node_->data; }
+
+    ConstIterator& operator++() {
+      if (node_->right) {
+        node_ = leftmost(node_->right.get());
+      } else {
+        const NodeT* child = node_;
+        node_ = node_->parent;
+        while (node_ && node_->right.get() == child) {
+          child = node_;
+          node_ = node_->parent;
+        }
+      }
+      return *this;
+    }
+
+    ConstIterator operator++(int) {
+      ConstIterator old = *this;
+      ++*this;
+      return old;
+    }
+
+    ConstIterator& operator--() {
+      if (!node_) {
+        node_ = rightmost(tree_->root.get());
+      } else if (node_->left) {
+        node_ = rightmost(node_->left.get());
+      } else {
+        const NodeT* child = node_;
+        node_ = node_->parent;
+        while (node_ && node_->left.get() == child) {
+          child = node_;
+          node_ = node_->parent;
+        }
+      }
+      return *this;
+    }
+
+    ConstIterator operator--(int) {
+      ConstIterator old = *this;
+      --*this;
+      return old;
+    }
+
+    bool operator==(const ConstIterator& other) const {
+      return node_ == other.node_;
+    }
+
+   private:
+    friend class BinaryTree;
+    ConstIterator(const NodeT* node, const BinaryTree* tree)
+        : node_(node), tree_(tree) {}
+
+    const NodeT* node_ = nullptr;
+    const BinaryTree* tree_ = nullptr;
+  };
+
+  using const_iterator = ConstIterator;
+
+  BinaryTree() = default;
+  ~BinaryTree() { clear(); }
+  BinaryTree(const BinaryTree&) = delete;
+  BinaryTree& operator=(const BinaryTree&) = delete;
+  // A moved-from tree is empty, with both root and count reset.
+  BinaryTree(BinaryTree&& other) noexcept
+      : root(std::move(other.root)), count(std::exchange(other.count, 0)) {}
+  BinaryTree& operator=(BinaryTree&& other) noexcept {
+    if (this != &other) {
+      clear();
+      root = std::move(other.root);
+      count = std::exchange(other.count, 0);
+    }
+    return *this;
+  }
+
+  // Builds a perfectly balanced tree from strictly increasing values in O(n),
+  // instead of n inserts with their O(log n) searches and rebalancing.
+  static BinaryTree fromSorted(std::span<const T> values) {
+    const auto out_of_order = std::ranges::adjacent_find(
+        values, [](const T& a, const T& b) { return !(a < b); });
+    if (out_of_order != values.end()) {
+      throw std::invalid_argument("fromSorted: values must strictly increase");
+    }
+
+    BinaryTree tree;
+    // Splitting at the midpoint keeps every null link at depth d or d + 1,
+    // so coloring the deepest level red gives equal black heights.
+    const int deepest =
+        static_cast<int>(std::bit_width(values.size())) - 1;
+    tree.root = build(values, nullptr, 0, deepest);
+    tree.count = values.size();
+    return tree;
+  }
+
+  // Returns false if the value was already present.
+  bool insert(const T& value) {
+    NodeT* parent = nullptr;
+    std::unique_ptr<NodeT>* slot = &root;
+    while (*slot) {
+      parent = slot->get();
+      if (value < parent->data) {
+        slot = &parent->left;
+      } else if (parent->data < value) {
+        slot = &parent->right;
+      } else {
+        return false;
+      }
+    }
+
+    *slot = std::make_unique<NodeT>(value);
+    NodeT* node = slot->get();
+    node->parent = parent;
+    ++count;
+    for (NodeT* ancestor = parent; ancestor; ancestor = ancestor->parent) {
+      ++ancestor->size;
+    }
+
+    if constexpr (B == Balancing::AVL) {
+      rebalanceAvl(parent);
+    } else if constexpr (B == Balancing::RED_BLACK) {
+      fixRedBlackInsert(node);
+    }
+    return true;
+  }
+
+  // Returns false if the value was not present.
+  bool erase(const T& value) {
+    NodeT* node = findNode(value);
+    if (!node) return false;
+
+    // A node with two children takes over its successor's value, and the
+    // successor, which has no left child, is unlinked instead.
+    if (node->left && node->right) {
+      NodeT* successor = node->right.get();
+      while (successor->left) successor = successor->left.get();
+      node->data = std::move(successor->data);
+      node = successor;
+    }
+
+    NodeT* parent = node->parent;
+    std::unique_ptr<NodeT>& slot = ownerOf(node);
+    std::unique_ptr<NodeT> child =
+        node->left ? std::move(node->left) : std::move(node->right);
+    if (child) child->parent = parent;
+    const bool removed_black = !node->red;
+    NodeT* replacement = child.get();
+    slot = std::move(child);  // destroys node
+    --count;
+    for (NodeT* ancestor = parent; ancestor; ancestor = ancestor->parent) {
+      --ancestor->size;
+    }
+
+    if constexpr (B == Balancing::AVL) {
+      rebalanceAvl(parent);
+    } else if constexpr (B == Balancing::RED_BLACK) {
+      if (removed_black) fixRedBlackErase(replacement, parent);
+    }
+    return true;
+  }
+
+  // Returns a pointer to the stored value, or nullptr if it is absent.
+  [[nodiscard]] const T* find(const T& value) const {
+    const NodeT* node = findNode(value);
+    return node ? &node->data : nullptr;
+  }
+
+  [[nodiscard]] bool search(const T& value) const {
+    return findNode(value) != nullptr;
+  }
+
+  [[nodiscard]] const_iterator begin() const {
+    return {root ? leftmost(root.get()) : nullptr, this};
+  }
+  [[nodiscard]] const_iterator end() const { return {nullptr, this}; }
+
+  // First element not less than value.
+  [[nodiscard]] const_iterator lower_bound(const T& value) const {
+    const NodeT* result = nullptr;
+    for (const NodeT* node = root.get(); node;) {
+      if (node->data < value) {
+        node = node->right.get();
+      } else {
+        result = node;
+        node = node->left.get();
+      }
+    }
+    return {result, this};
+  }
+
+  // First element greater than value.
+  [[nodiscard]] const_iterator upper_bound(const T& value) const {
+    const NodeT* result = nullptr;
+    for (const NodeT* node = root.get(); node;) {
+      if (value < node->data) {
+        result = node;
+        node = node->left.get();
+      } else {
+        node = node->right.get();
+      }
+    }
+    return {result, this};
+  }
+
+  // Elements in [lo, hi) as a view; costs O(log n) to position plus O(1)
+  // amortized per element visited.
+  [[nodiscard]] std::ranges::subrange<const_iterator> range(const T& lo,
+                                                            const T& hi) const {
+    if (hi < lo) return {end(), end()};
+    return {lower_bound(lo), lower_bound(hi)};
+  }
+
+  // The element at zero-based sorted position k, or end() if k >= size().
+  [[nodiscard]] const_iterator select(size_t k) const {
+    const NodeT* node = root.get();
+    while (node) {
+      const size_t left_size = subtreeSize(node->left.get());
+      if (k < left_size) {
+        node = node->left.get();
+      } else if (k > left_size) {
+        k -= left_size + 1;
+        node = node->right.get();
+      } else {
+        break;
+      }
+    }
+    return {node, this};
+  }
+
+  // Number of elements less than value.
+  [[nodiscard]] size_t rank(const T& value) const {
+    size_t result = 0;
+    for (const NodeT* node = root.get(); node;) {
+      if (node->data < value) {
+        result += subtreeSize(node->left.get()) + 1;
+        node = node->right.get();
+      } else {
+        node = node->left.get();
+      }
+    }
+    return result;
+  }
+
+  [[nodiscard]] size_t size() const noexcept { return count; }
+  [[nodiscard]] bool empty() const noexcept { return count == 0; }
+
+  // Number of levels, computed with an explicit queue instead of recursion.
+  [[nodiscard]] size_t height() const {
+    size_t levels = 0;
+    std::vector<const NodeT*> level;
+    if (root) level.push_back(root.get());
+    while (!level.empty()) {
+      ++levels;
+      std::vector<const NodeT*> next;
+      for (const NodeT* node : level) {
+        if (node->left) next.push_back(node->left.get());
+        if (node->right) next.push_back(node->right.get());
+      }
+      level = std::move(next);
+    }
+    return levels;
+  }
+
+  // Destroys the nodes one at a time; letting the unique_ptr chain unwind
+  // would recurse as deep as the tree is tall.
+  void clear() {
+    std::vector<std::unique_ptr<NodeT>> pending;
+    if (root) pending.push_back(std::move(root));
+    while (!pending.empty()) {
+      auto node = std::move(pending.back());
+      pending.pop_back();
+      if (node->left) pending.push_back(std::move(node->left));
+      if (node->right) pending.push_back(std::move(node->right));
+    }
+    count = 0;
+  }
+
+  void inOrderTraversal() const {
+    for (const T& value : *this) std::cout << value << ' ';
+    std::cout << '\n';
+  }
+
+  void preOrderTraversal() const {
+    std::vector<const NodeT*> pending;
+    if (root) pending.push_back(root.get());
+    while (!pending.empty()) {
+      const NodeT* node = pending.back();
+      pending.pop_back();
+      std::cout << node->data << ' ';
+      if (node->right) pending.push_back(node->right.get());
+      if (node->left) pending.push_back(node->left.get());
+    }
+    std::cout << '\n';
+  }
+
+  // Collects node-right-left order and prints it reversed.
+  void postOrderTraversal() const {
+    std::vector<const NodeT*> pending;
+    std::vector<const NodeT*> order;
+    if (root) pending.push_back(root.get());
+    while (!pending.empty()) {
+      const NodeT* node = pending.back();
+      pending.pop_back();
+      order.push_back(node);
+      if (node->left) pending.push_back(node->left.get());
+      if (node->right) pending.push_back(node->right.get());
+    }
+    for (const NodeT* node : order | std::views::reverse) {
+      std::cout << node->data << ' ';
+    }
+    std::cout << '\n';
+  }
+
+ private:
+  std::unique_ptr<NodeT> root{nullptr};
+  size_t count{0};
+
+  NodeT* findNode(const T& value) const {
+    NodeT* node = root.get();
+    while (node) {
+      if (value < node->data) {
+        node = node->left.get();
+      } else if (node->data < value) {
+        node = node->right.get();
+      } else {
+        return node;
+      }
+    }
+    return nullptr;
+  }
+
+  // The unique_ptr that owns node: the root or a child link of its parent.
+  std::unique_ptr<NodeT>& ownerOf(NodeT* node) {
+    if (!node->parent) return root;
+    return node->parent->left.get() == node ? node->parent->left
+                                            : node->parent->right;
+  }
+
+  // Moves x's right child y into x's place, x becomes y's left child.
+  NodeT* rotateLeft(NodeT* x) {
+    std::unique_ptr<NodeT>& slot = ownerOf(x);
+    std::unique_ptr<NodeT> x_owned = std::move(slot);
+    std::unique_ptr<NodeT> y_owned = std::move(x_owned->right);
+    x_owned->right = std::move(y_owned->left);
+    if (x_owned->right) x_owned->right->parent = x;
+    y_owned->parent = x->parent;
+    x->parent = y_owned.get();
+    y_owned->size = x->size;
+    updateSize(x);
+    y_owned->left = std::move(x_owned);
+    slot = std::move(y_owned);
+    return slot.get();
+  }
+
+  // Mirror image of rotateLeft().
+  NodeT* rotateRight(NodeT* x) {
+    std::unique_ptr<NodeT>& slot = ownerOf(x);
+    std::unique_ptr<NodeT> x_owned = std::move(slot);
+    std::unique_ptr<NodeT> y_owned = std::move(x_owned->left);
+    x_owned->left = std::move(y_owned->right);
+    if (x_owned->left) x_owned->left->parent = x;
+    y_owned->parent = x->parent;
+    x->parent = y_owned.get();
+    y_owned->size = x->size;
+    updateSize(x);
+    y_owned->right = std::move(x_owned);
+    slot = std::move(y_owned);
+    return slot.get();
+  }
+
+  static std::unique_ptr<NodeT> build(std::span<const T> values, NodeT* parent,
+                                      int depth, int deepest) {
+    if (values.empty()) return nullptr;
+    const size_t mid = values.size() / 2;
+    auto node = std::make_unique<NodeT>(values[mid]);
+    node->parent = parent;
+    node->left = build(values.first(mid), node.get(), depth + 1, deepest);
+    node->right =
+        build(values.subspan(mid + 1), node.get(), depth + 1, deepest);
+    node->size = values.size();
+    node->red = depth > 0 && depth == deepest;
+    updateHeight(node.get());
+    return node;
+  }
+
+  static const NodeT* leftmost(const NodeT* node) {
+    while (node && node->left) node = node->left.get();
+    return node;
+  }
+
+  static const NodeT* rightmost(const NodeT* node) {
+    while (node && node->right) node = node->right.get();
+    return node;
+  }
+
+  static size_t subtreeSize(const NodeT* node) {
+    return node ? node->size : 0;
+  }
+
+  static void updateSize(NodeT* node) {
+    node->size =
+        1 + subtreeSize(node->left.get()) + subtreeSize(node->right.get());
+  }
+
+  static int height(const std::unique_ptr<NodeT>& node) {
+    return node ? node->height : 0;
+  }
+
+  static void updateHeight(NodeT* node) {
+    node->height = static_cast<int8_t>(
+        1 + std::max(height(node->left), height(node->right)));
+  }
+
+  // Walks from node up to the root, restoring the AVL invariant (subtree
+  // heights differ by at most one) with single or double rotations.
+  void rebalanceAvl(NodeT* node) {
+    while (node) {
+      updateHeight(node);
+      const int balance = height(node->left) - height(node->right);
+      if (balance > 1) {
+        if (height(node->left->left) < height(node->left->right)) {
+          updateHeight(rotateLeft(node->left.get())->left.get());
+        }
+        node = rotateRight(node);
+        updateHeight(node->right.get());
+        updateHeight(node);
+      } else if (balance < -1) {
+        if (height(node->right->right) < height(node->right->left)) {
+          updateHeight(rotateRight(node->right.get())->right.get());
+        }
+        node = rotateLeft(node);
+        updateHeight(node->left.get());
+        updateHeight(node);
+      }
+      node = node->parent;
+    }
+  }
+
+  static bool isRed(const NodeT* node) { return node && node->red; }
+
+  void fixRedBlackInsert(NodeT* node) {
+    while (isRed(node->parent)) {
+      NodeT* parent = node->parent;
+      NodeT* grandparent = parent->parent;
+      const bool parent_is_left = grandparent->left.get() == parent;
+      NodeT* uncle = parent_is_left ? grandparent->right.get()
+                                    : grandparent->left.get();
+      if (isRed(uncle)) {
+        parent->red = false;
+        uncle->red = false;
+        grandparent->red = true;
+        node = grandparent;
+        continue;
+      }
+
+      if (parent_is_left) {
+        if (parent->right.get() == node) {
+          node = parent;
+          rotateLeft(node);
+          parent = node->parent;
+        }
+        parent->red = false;
+        grandparent->red = true;
+        rotateRight(grandparent);
+      } else {
+        if (parent->left.get() == node) {
+          node = parent;
+          rotateRight(node);
+          parent = node->parent;
+        }
+        parent->red = false;
+        grandparent->red = true;
+        rotateLeft(grandparent);
+      }
+    }
+    root->red = false;
+  }
+
+  // node replaced a removed black node and carries an extra black; it may be
+  // nullptr, so its parent is passed separately.
+  void fixRedBlackErase(NodeT* node, NodeT* parent) {
+    while (node != root.get() && !isRed(node)) {
+      if (parent->left.get() == node) {
+        NodeT* sibling = parent->right.get();
+        if (isRed(sibling)) {
+          sibling->red = false;
+          parent->red = true;
+          rotateLeft(parent);
+          sibling = parent->right.get();
+        }
+        if (!sibling) break;  // a valid tree always has one here
+        if (!isRed(sibling->left.get()) && !isRed(sibling->right.get())) {
+          sibling->red = true;
+          node = parent;
+          parent = node->parent;
+          continue;
+        }
+        if (!isRed(sibling->right.get())) {
+          sibling->left->red = false;
+          sibling->red = true;
+          rotateRight(sibling);
+          sibling = parent->right.get();
+        }
+        sibling->red = parent->red;
+        parent->red = false;
+        sibling->right->red = false;
+        rotateLeft(parent);
+      } else {
+        NodeT* sibling = parent->left.get();
+        if (isRed(sibling)) {
+          sibling->red = false;
+          parent->red = true;
+          rotateRight(parent);
+          sibling = parent->left.get();
+        }
+        if (!sibling) break;  // a valid tree always has one here
+        if (!isRed(sibling->left.get()) && !isRed(sibling->right.get())) {
+          sibling->red = true;
+          node = parent;
+          parent = node->parent;
+          continue;
+        }
+        if (!isRed(sibling->left.get())) {
+          sibling->right->red = false;
+          sibling->red = true;
+          rotateLeft(sibling);
+          sibling = parent->left.get();
+        }
+        sibling->red = parent->red;
+        parent->red = false;
+        sibling->left->red = false;
+        rotateRight(parent);
+      }
+      node = root.get();
+    }
+    if (node) node->red = false;
+  }
+};
+
+static_assert(std::bidirectional_iterator<BinaryTree<int>::const_iterator>);
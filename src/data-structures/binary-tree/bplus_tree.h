@@ -0,0 +1,364 @@
+#pragma once
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+
+namespace bplus_detail {
+
+// Number of keys[0, count) that are less than key (OrEqual: less or equal).
+// Keys are sorted, so this is the lower_bound (upper_bound) position. 32- and
+// 64-bit integer keys are compared 8 or 4 at a time with AVX2, everything else
+// uses a branchless loop. Reads whole SIMD blocks, so the array must be
+// allocated in multiples of 8 keys.
+template <bool OrEqual, typename Key>
+size_t rank(const Key* keys, size_t count, const Key& key) {
+#if defined(__AVX2__)
+  if constexpr (std::is_same_v<Key, int32_t> || std::is_same_v<Key, int64_t>) {
+    constexpr size_t kLanes = 32 / sizeof(Key);
+    const __m256i needle = sizeof(Key) == 4
+                               ? _mm256_set1_epi32(static_cast<int32_t>(key))
+                               : _mm256_set1_epi64x(static_cast<int64_t>(key));
+    size_t result = 0;
+    for (size_t i = 0; i < count; i += kLanes) {
+      const __m256i block =
+          _mm256_loadu_si256(reinterpret_cast<const __m256i*>(keys + i));
+      // less: key > block, less or equal: !(block > key)
+      __m256i cmp;
+      if constexpr (sizeof(Key) == 4) {
+        cmp = OrEqual ? _mm256_cmpgt_epi32(block, needle)
+                      : _mm256_cmpgt_epi32(needle, block);
+      } else {
+        cmp = OrEqual ? _mm256_cmpgt_epi64(block, needle)
+                      : _mm256_cmpgt_epi64(needle, block);
+      }
+      auto bits = static_cast<unsigned>(
+          sizeof(Key) == 4 ? _mm256_movemask_ps(_mm256_castsi256_ps(cmp))
+                           : _mm256_movemask_pd(_mm256_castsi256_pd(cmp)));
+      const size_t valid = std::min(kLanes, count - i);
+      const unsigned valid_mask = (1u << valid) - 1;
+      if constexpr (OrEqual) bits = ~bits;
+      result += static_cast<size_t>(std::popcount(bits & valid_mask));
+    }
+    return result;
+  }
+#endif
+  size_t result = 0;
+  for (size_t i = 0; i < count; ++i) {
+    if constexpr (OrEqual) {
+      result += static_cast<size_t>(!(key < keys[i]));
+    } else {
+      result += static_cast<size_t>(keys[i] < key);
+    }
+  }
+  return result;
+}
+
+}  // namespace bplus_detail
+
+// Ordered map stored as a B+-tree. Every node spans a few cache lines and
+// keeps its keys in one contiguous array that is searched with SIMD, so a
+// lookup touches one node per level instead of one node per comparison. All
+// values live in the leaves, which are linked for sequential range scans.
+//
+// Values must be default constructible. erase() does not merge underfull
+// leaves; scans skip leaves that became empty.
+template <typename Key, typename Value, size_t NodeBytes = 256>
+class BPlusTree {
+  static constexpr size_t roundToSimdBlock(size_t n) {
+    return std::max<size_t>(8, n / 8 * 8);
+  }
+  static constexpr size_t kLeafCapacity =
+      roundToSimdBlock((NodeBytes - 32) / (sizeof(Key) + sizeof(Value)));
+  static constexpr size_t kInnerCapacity =
+      roundToSimdBlock((NodeBytes - 16) / (sizeof(Key) + sizeof(void*)));
+  static constexpr size_t kMaxDepth = 64;
+
+  struct NodeBase {
+    uint32_t count = 0;
+    bool leaf = false;
+  };
+
+  struct alignas(64) Leaf : NodeBase {
+    std::array<Key, kLeafCapacity> keys{};
+    std::array<Value, kLeafCapacity> values{};
+    Leaf* next = nullptr;
+    Leaf() { this->leaf = true; }
+  };
+
+  // children[i] holds the keys in [keys[i - 1], keys[i]).
+  struct alignas(64) Inner : NodeBase {
+    std::array<Key, kInnerCapacity> keys{};
+    std::array<NodeBase*, kInnerCapacity + 1> children{};
+  };
+
+ public:
+  class ConstIterator {
+   public:
+    ConstIterator() = default;
+
+    [[nodiscard]] const Key& key() const { return leaf_->keys[index_]; }
+    [[nodiscard]] const Value& value() const { return leaf_->values[index_]; }
+
+    ConstIterator& operator++() {
+      ++index_;
+      skipExhausted();
+      return *this;
+    }
+
+    bool operator==(const ConstIterator&) const = default;
+
+   private:
+    friend class BPlusTree;
+    ConstIterator(const Leaf* leaf, size_t index) : leaf_(leaf), index_(index) {
+      skipExhausted();
+    }
+
+    void skipExhausted() {
+      while (leaf_ && index_ >= leaf_->count) {
+        leaf_ = leaf_->next;
+        index_ = 0;
+      }
+    }
+
+    const Leaf* leaf_ = nullptr;
+    size_t index_ = 0;
+  };
+
+  BPlusTree() = default;
+  ~BPlusTree() { destroy(root_); }
+  BPlusTree(const BPlusTree&) = delete;
+  BPlusTree& operator=(const BPlusTree&) = delete;
+  BPlusTree(BPlusTree&& other) noexcept
+      : root_(std::exchange(other.root_, nullptr)),
+        first_leaf_(std::exchange(other.first_leaf_, nullptr)),
+        size_(std::exchange(other.size_, 0)) {}
+  BPlusTree& operator=(BPlusTree&& other) noexcept {
+    std::swap(root_, other.root_);
+    std::swap(first_leaf_, other.first_leaf_);
+    std::swap(size_, other.size_);
+    return *this;
+  }
+
+  // Returns false (and keeps the old value) if the key was already present.
+  bool insert(const Key& key, const Value& value) {
+    if (!root_) {
+      first_leaf_ = new Leaf();
+      root_ = first_leaf_;
+    }
+
+    std::array<std::pair<Inner*, size_t>, kMaxDepth> path;
+    size_t depth = 0;
+    Leaf* leaf = descend(key, path.data(), depth);
+    size_t pos = bplus_detail::rank<false>(leaf->keys.data(), leaf->count, key);
+    if (pos < leaf->count && !(key < leaf->keys[pos])) return false;
+
+    if (leaf->count == kLeafCapacity) {
+      Leaf* right = splitLeaf(leaf);
+      if (pos > leaf->count) {
+        pos -= leaf->count;
+        leaf = right;
+      }
+      insertIntoLeaf(leaf, pos, key, value);
+      insertIntoParent(path.data(), depth, right->keys[0], right);
+    } else {
+      insertIntoLeaf(leaf, pos, key, value);
+    }
+    ++size_;
+    return true;
+  }
+
+  // Returns false if the key was not present.
+  bool erase(const Key& key) {
+    if (!root_) return false;
+    Leaf* leaf = descend(key);
+    const size_t pos =
+        bplus_detail::rank<false>(leaf->keys.data(), leaf->count, key);
+    if (pos == leaf->count || key < leaf->keys[pos]) return false;
+
+    std::move(leaf->keys.begin() + static_cast<std::ptrdiff_t>(pos + 1),
+              leaf->keys.begin() + leaf->count,
+              leaf->keys.begin() + static_cast<std::ptrdiff_t>(pos));
+    std::move(leaf->values.begin() + static_cast<std::ptrdiff_t>(pos + 1),
+              leaf->values.begin() + leaf->count,
+              leaf->values.begin() + static_cast<std::ptrdiff_t>(pos));
+    --leaf->count;
+    --size_;
+    return true;
+  }
+
+  // Returns a pointer to the value stored for key, or nullptr.
+  [[nodiscard]] const Value* find(const Key& key) const {
+    if (!root_) return nullptr;
+    const Leaf* leaf = descend(key);
+    const size_t pos =
+        bplus_detail::rank<false>(leaf->keys.data(), leaf->count, key);
+    if (pos == leaf->count || key < leaf->keys[pos]) return nullptr;
+    return &leaf->values[pos];
+  }
+
+  [[nodiscard]] bool contains(const Key& key) const {
+    return find(key) != nullptr;
+  }
+
+  // First element whose key is not less than key.
+  [[nodiscard]] ConstIterator lower_bound(const Key& key) const {
+    if (!root_) return end();
+    const Leaf* leaf = descend(key);
+    return {leaf, bplus_detail::rank<false>(leaf->keys.data(), leaf->count,
+                                            key)};
+  }
+
+  [[nodiscard]] ConstIterator begin() const { return {first_leaf_, 0}; }
+  [[nodiscard]] ConstIterator end() const { return {}; }
+
+  // Calls fn(key, value) for every key in [lo, hi), walking the leaf chain.
+  template <typename Fn>
+  void scan(const Key& lo, const Key& hi, Fn&& fn) const {
+    if (!root_) return;
+    const Leaf* leaf = descend(lo);
+    size_t i = bplus_detail::rank<false>(leaf->keys.data(), leaf->count, lo);
+    for (; leaf; leaf = leaf->next, i = 0) {
+      for (; i < leaf->count; ++i) {
+        if (!(leaf->keys[i] < hi)) return;
+        fn(leaf->keys[i], leaf->values[i]);
+      }
+    }
+  }
+
+  [[nodiscard]] size_t size() const noexcept { return size_; }
+  [[nodiscard]] bool empty() const noexcept { return size_ == 0; }
+
+  [[nodiscard]] size_t height() const {
+    size_t levels = 0;
+    for (const NodeBase* node = root_; node;
+         node = node->leaf ? nullptr
+                           : static_cast<const Inner*>(node)->children[0]) {
+      ++levels;
+    }
+    return levels;
+  }
+
+ private:
+  // Walks from the root to the leaf that may hold key. If path is given, it
+  // receives every inner node on the way and the child index taken.
+  Leaf* descend(const Key& key, std::pair<Inner*, size_t>* path,
+                size_t& depth) const {
+    NodeBase* node = root_;
+    while (!node->leaf) {
+      auto* inner = static_cast<Inner*>(node);
+      const size_t child =
+          bplus_detail::rank<true>(inner->keys.data(), inner->count, key);
+      if (path) path[depth++] = {inner, child};
+      node = inner->children[child];
+    }
+    return static_cast<Leaf*>(node);
+  }
+
+  Leaf* descend(const Key& key) const {
+    size_t depth = 0;
+    return descend(key, nullptr, depth);
+  }
+
+  static void insertIntoLeaf(Leaf* leaf, size_t pos, const Key& key,
+                             const Value& value) {
+    const auto first = static_cast<std::ptrdiff_t>(pos);
+    const auto last = static_cast<std::ptrdiff_t>(leaf->count);
+    std::move_backward(leaf->keys.begin() + first, leaf->keys.begin() + last,
+                       leaf->keys.begin() + last + 1);
+    std::move_backward(leaf->values.begin() + first,
+                       leaf->values.begin() + last,
+                       leaf->values.begin() + last + 1);
+    leaf->keys[pos] = key;
+    leaf->values[pos] = value;
+    ++leaf->count;
+  }
+
+  // Moves the upper half of a full leaf into a new right sibling.
+  static Leaf* splitLeaf(Leaf* leaf) {
+    auto* right = new Leaf();
+    constexpr size_t kKeep = kLeafCapacity / 2;
+    std::move(leaf->keys.begin() + kKeep, leaf->keys.end(),
+              right->keys.begin());
+    std::move(leaf->values.begin() + kKeep, leaf->values.end(),
+              right->values.begin());
+    right->count = static_cast<uint32_t>(kLeafCapacity - kKeep);
+    leaf->count = static_cast<uint32_t>(kKeep);
+    right->next = leaf->next;
+    leaf->next = right;
+    return right;
+  }
+
+  // Adds separator/right next to the child that was split, splitting full
+  // inner nodes on the way up and growing a new root if needed.
+  void insertIntoParent(std::pair<Inner*, size_t>* path, size_t depth,
+                        Key separator, NodeBase* right) {
+    while (depth > 0) {
+      auto [inner, child] = path[--depth];
+      if (inner->count < kInnerCapacity) {
+        for (size_t i = inner->count; i > child; --i) {
+          inner->keys[i] = inner->keys[i - 1];
+          inner->children[i + 1] = inner->children[i];
+        }
+        inner->keys[child] = separator;
+        inner->children[child + 1] = right;
+        ++inner->count;
+        return;
+      }
+
+      // Merge the new entry into scratch arrays, then split them around the
+      // middle key, which moves up instead of being copied.
+      std::array<Key, kInnerCapacity + 1> keys;
+      std::array<NodeBase*, kInnerCapacity + 2> children;
+      for (size_t i = 0, j = 0; i < keys.size(); ++i) {
+        keys[i] = i == child ? separator : inner->keys[j++];
+      }
+      for (size_t i = 0, j = 0; i < children.size(); ++i) {
+        children[i] = i == child + 1 ? right : inner->children[j++];
+      }
+
+      constexpr size_t kKeep = keys.size() / 2;
+      auto* sibling = new Inner();
+      std::copy(keys.begin(), keys.begin() + kKeep, inner->keys.begin());
+      std::copy(children.begin(), children.begin() + kKeep + 1,
+                inner->children.begin());
+      std::copy(keys.begin() + kKeep + 1, keys.end(), sibling->keys.begin());
+      std::copy(children.begin() + kKeep + 1, children.end(),
+                sibling->children.begin());
+      inner->count = static_cast<uint32_t>(kKeep);
+      sibling->count = static_cast<uint32_t>(keys.size() - kKeep - 1);
+      separator = keys[kKeep];
+      right = sibling;
+    }
+
+    auto* root = new Inner();
+    root->keys[0] = separator;
+    root->children[0] = root_;
+    root->children[1] = right;
+    root->count = 1;
+    root_ = root;
+  }
+
+  static void destroy(NodeBase* node) {
+    if (!node) return;
+    if (node->leaf) {
+      delete static_cast<Leaf*>(node);
+      return;
+    }
+    auto* inner = static_cast<Inner*>(node);
+    for (size_t i = 0; i <= inner->count; ++i) destroy(inner->children[i]);
+    delete inner;
+  }
+
+  NodeBase* root_ = nullptr;
+  Leaf* first_leaf_ = nullptr;
+  size_t size_ = 0;
+};
@@ -0,0 +1,100 @@
+#pragma once
+
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <xmmintrin.h>
+#endif
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <span>
+#include <stdexcept>
+#include <vector>
+
+#include "binary_tree.h"
+
+// Immutable search tree stored in Eytzinger (breadth-first) order: the
+// children of slot k are slots 2k and 2k + 1 of one contiguous array. There
+// are no pointers to chase, and the top levels that every search visits share
+// a few hot cache lines. Build it once from read-mostly data, then query.
+template <typename T>
+class FrozenTree {
+ public:
+  FrozenTree() = default;
+
+  // values must be sorted and strictly increasing.
+  explicit FrozenTree(std::span<const T> values) : data_(values.size() + 1) {
+    const auto out_of_order = std::ranges::adjacent_find(
+        values, [](const T& a, const T& b) { return !(a < b); });
+    if (out_of_order != values.end()) {
+      throw std::invalid_argument("FrozenTree: values must strictly increase");
+    }
+    size_t next = 0;
+    fill(values, next, 1);
+  }
+
+  // Freezes a tree using its in-order iterators.
+  template <Balancing B>
+  explicit FrozenTree(const BinaryTree<T, B>& tree)
+      : FrozenTree(std::vector<T>(tree.begin(), tree.end())) {}
+
+  // First element not less than value, or nullptr. The loop has no
+  // data-dependent branch: each step picks a child with the comparison
+  // result, and the line holding its descendants log2(kPrefetchStride)
+  // levels down is prefetched meanwhile.
+  [[nodiscard]] const T* lower_bound(const T& value) const {
+    const size_t n = size();
+    size_t k = 1;
+    while (k <= n) {
+      prefetch(data_.data() + k * kPrefetchStride);
+      k = 2 * k + static_cast<size_t>(data_[k] < value);
+    }
+    // k took a right turn at every "less" node after the last "not less"
+    // one; dropping those trailing ones and one more bit recovers it.
+    k >>= std::countr_one(k) + 1;
+    return k == 0 ? nullptr : &data_[k];
+  }
+
+  [[nodiscard]] const T* find(const T& value) const {
+    const T* candidate = lower_bound(value);
+    return candidate && !(value < *candidate) ? candidate : nullptr;
+  }
+
+  [[nodiscard]] bool contains(const T& value) const {
+    return find(value) != nullptr;
+  }
+
+  [[nodiscard]] size_t size() const noexcept {
+    return data_.empty() ? 0 : data_.size() - 1;
+  }
+  [[nodiscard]] bool empty() const noexcept { return size() == 0; }
+
+ private:
+  // The descendants of slot k that are L levels down fill slots k * 2^L to
+  // k * 2^L + 2^L - 1. With kPrefetchStride = 2^L elements per cache line
+  // they share one line, so the search prefetches log2(kPrefetchStride)
+  // levels ahead: 4 for 4-byte T, 3 for 8-byte T, 6 for 1-byte T. The
+  // stride is rounded down to a power of two for other element sizes.
+  static constexpr size_t kPrefetchStride =
+      std::bit_floor(std::max<size_t>(1, 64 / sizeof(T)));
+
+  // In-order walk of the implicit tree assigns the sorted values to slots.
+  // Recursion depth is log2(n).
+  void fill(std::span<const T> values, size_t& next, size_t k) {
+    if (k >= data_.size()) return;
+    fill(values, next, 2 * k);
+    data_[k] = values[next++];
+    fill(values, next, 2 * k + 1);
+  }
+
+  // Prefetching past the end of the array is harmless, so no bounds check.
+  static void prefetch(const T* address) {
+#if defined(__GNUC__) || defined(__clang__)
+    __builtin_prefetch(address);
+#elif defined(_MSC_VER)
+    _mm_prefetch(reinterpret_cast<const char*>(address), _MM_HINT_T0);
+#endif
+  }
+
+  std::vector<T> data_;  // slot 0 unused
+};
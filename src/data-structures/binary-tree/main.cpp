@@ -1,91 +1,238 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
 #include <iostream>
-#include <memory>
-
-template <typename T>
-struct Node {
-  T data;
-  std::unique_ptr<Node<T>> left{nullptr};
-  std::unique_ptr<Node<T>> right{nullptr};
-  explicit Node(const T& value) : data(value) {}
-};
+#include <numeric>
+#include <random>
+#include <ranges>
+#include <set>
+#include <string_view>
+#include <vector>
 
-template <typename T>
-class BinaryTree {
- public:
-  void insert(const T& value) {
-    if (!root) {
-      root = std::make_unique<Node<T>>(value);
-    } else {
-      insert(value, root.get());
-    }
+#include "binary_tree.h"
+#include "bplus_tree.h"
+#include "frozen_tree.h"
+
+// Keys drawn from a Zipf distribution (exponent s) over [0, universe): a few
+// hot keys repeat often, like lookups in real workloads.
+std::vector<int> zipfianKeys(size_t n, size_t universe, double s,
+                             std::mt19937& rng) {
+  std::vector<double> cdf(universe);
+  double sum = 0.0;
+  for (size_t i = 0; i < universe; ++i) {
+    sum += 1.0 / std::pow(static_cast<double>(i + 1), s);
+    cdf[i] = sum;
   }
+  std::uniform_real_distribution<double> dist(0.0, sum);
+  std::vector<int> keys(n);
+  for (auto& key : keys) {
+    const auto rank = std::ranges::lower_bound(cdf, dist(rng)) - cdf.begin();
+    key = static_cast<int>(rank);
+  }
+  // Scatter the ranks so hot keys are not also the smallest keys.
+  std::vector<int> permutation(universe);
+  std::iota(permutation.begin(), permutation.end(), 0);
+  std::ranges::shuffle(permutation, rng);
+  for (auto& key : keys) key = permutation[static_cast<size_t>(key)];
+  return keys;
+}
 
-  void inOrderTraversal() const {
-    inOrderTraversal(root.get());
-    std::cout << '\n';
+template <typename Tree>
+void benchmarkTree(std::string_view name, const std::vector<int>& keys) {
+  using Clock = std::chrono::steady_clock;
+  Tree tree;
+
+  const auto insert_start = Clock::now();
+  for (int key : keys) tree.insert(key);
+  const auto insert_end = Clock::now();
+
+  size_t found = 0;
+  for (int key : keys) {
+    if (tree.find(key) != nullptr) ++found;
   }
+  const auto find_end = Clock::now();
 
-  void preOrderTraversal() const {
-    preOrderTraversal(root.get());
-    std::cout << '\n';
+  const auto per_key = [&](auto duration) {
+    return std::chrono::duration<double, std::nano>(duration).count() /
+           static_cast<double>(keys.size());
+  };
+  std::cout << "  " << name << ": insert " << per_key(insert_end - insert_start)
+            << " ns/key, find " << per_key(find_end - insert_end)
+            << " ns/key, found " << found;
+  if constexpr (requires { tree.height(); }) {
+    std::cout << ", height " << tree.height();
   }
+  std::cout << '\n';
+}
 
-  void postOrderTraversal() const {
-    postOrderTraversal(root.get());
-    std::cout << '\n';
+// std::set adapter so it can be measured with the same harness.
+struct StdSet : std::set<int> {
+  [[nodiscard]] const int* find(int key) const {
+    auto it = std::set<int>::find(key);
+    return it == end() ? nullptr : &*it;
   }
+};
+
+void benchmarkInsertOrder(std::string_view order,
+                          const std::vector<int>& keys) {
+  std::cout << "Insert order: " << order << " (" << keys.size() << " keys)\n";
+  benchmarkTree<BinaryTree<int>>("unbalanced", keys);
+  benchmarkTree<BinaryTree<int, Balancing::AVL>>("avl", keys);
+  benchmarkTree<BinaryTree<int, Balancing::RED_BLACK>>("red-black", keys);
+  benchmarkTree<StdSet>("std::set", keys);
+}
+
+void benchmarkInsertOrders() {
+  constexpr size_t kKeys = 20'000;
+  std::mt19937 rng(42);
+
+  std::vector<int> sorted(kKeys);
+  std::iota(sorted.begin(), sorted.end(), 0);
+  std::vector<int> random = sorted;
+  std::ranges::shuffle(random, rng);
+
+  benchmarkInsertOrder("sorted", sorted);
+  benchmarkInsertOrder("random", random);
+  benchmarkInsertOrder("zipfian", zipfianKeys(kKeys, kKeys, 1.0, rng));
+}
 
-  [[nodiscard]] bool search(const T& value) const {
-    return search(value, root.get());
+// Point lookups and short range scans over a large index, where the pointer
+// BST pays a cache miss per level and the B+-tree one per node.
+void benchmarkOrderedIndex() {
+  using Clock = std::chrono::steady_clock;
+  constexpr size_t kKeys = 500'000;
+  constexpr int kRangeWidth = 100;
+  std::mt19937 rng(7);
+
+  std::vector<int> keys(kKeys);
+  std::iota(keys.begin(), keys.end(), 0);
+  std::ranges::shuffle(keys, rng);
+  std::vector<int> probes = keys;
+  std::ranges::shuffle(probes, rng);
+
+  BinaryTree<int, Balancing::RED_BLACK> bst;
+  std::set<int> set;
+  BPlusTree<int, int> bplus;
+  for (int key : keys) {
+    bst.insert(key);
+    set.insert(key);
+    bplus.insert(key, key);
   }
 
- private:
-  std::unique_ptr<Node<T>> root{nullptr};
+  const auto per_probe = [&](auto duration) {
+    return std::chrono::duration<double, std::nano>(duration).count() /
+           static_cast<double>(probes.size());
+  };
+
+  std::cout << "Ordered index (" << kKeys << " keys), lookup / range of "
+            << kRangeWidth << ":\n";
+
+  auto start = Clock::now();
+  size_t found = 0;
+  for (int key : probes) {
+    if (bst.find(key) != nullptr) ++found;
+  }
+  std::cout << "  red-black: lookup " << per_probe(Clock::now() - start)
+            << " ns, found " << found << '\n';
 
-  void insert(const T& value, Node<T>* node) {
-    if (value < node->data) {
-      if (!node->left) {
-        node->left = std::make_unique<Node<T>>(value);
-      } else {
-        insert(value, node->left.get());
-      }
-    } else if (value > node->data) {
-      if (!node->right) {
-        node->right = std::make_unique<Node<T>>(value);
-      } else {
-        insert(value, node->right.get());
-      }
+  start = Clock::now();
+  found = 0;
+  for (int key : probes) {
+    if (set.contains(key)) ++found;
+  }
+  const auto set_lookup = Clock::now() - start;
+  start = Clock::now();
+  long long sum = 0;
+  for (int key : probes) {
+    for (auto it = set.lower_bound(key);
+         it != set.end() && *it < key + kRangeWidth; ++it) {
+      sum += *it;
     }
   }
+  std::cout << "  std::set: lookup " << per_probe(set_lookup) << " ns, range "
+            << per_probe(Clock::now() - start) << " ns, found " << found
+            << ", sum " << sum << '\n';
 
-  static void inOrderTraversal(const Node<T>* node) {
-    if (!node) return;
-    inOrderTraversal(node->left.get());
-    std::cout << node->data << ' ';
-    inOrderTraversal(node->right.get());
+  start = Clock::now();
+  found = 0;
+  for (int key : probes) {
+    if (bplus.contains(key)) ++found;
+  }
+  const auto bplus_lookup = Clock::now() - start;
+  start = Clock::now();
+  sum = 0;
+  for (int key : probes) {
+    bplus.scan(key, key + kRangeWidth, [&](int k, int) { sum += k; });
   }
+  std::cout << "  b+tree: lookup " << per_probe(bplus_lookup) << " ns, range "
+            << per_probe(Clock::now() - start) << " ns, found " << found
+            << ", sum " << sum << ", height " << bplus.height() << '\n';
+}
+
+// Nightly rebuild of a read-only table: bulk build versus inserts, then
+// lookups in pointer, Eytzinger and plain sorted-array layouts.
+void benchmarkReadMostly() {
+  using Clock = std::chrono::steady_clock;
+  constexpr size_t kKeys = 1 << 20;
+  std::vector<int> sorted(kKeys);
+  for (size_t i = 0; i < kKeys; ++i) sorted[i] = static_cast<int>(2 * i);
+  std::mt19937 rng(11);
+  std::uniform_int_distribution<int> dist(0, static_cast<int>(2 * kKeys));
+  std::vector<int> probes(kKeys);
+  for (auto& probe : probes) probe = dist(rng);
+
+  const auto millis = [](auto duration) {
+    return std::chrono::duration<double, std::milli>(duration).count();
+  };
+  const auto per_probe = [&](auto duration) {
+    return std::chrono::duration<double, std::nano>(duration).count() /
+           static_cast<double>(probes.size());
+  };
 
-  static void preOrderTraversal(const Node<T>* node) {
-    if (!node) return;
-    std::cout << node->data << ' ';
-    preOrderTraversal(node->left.get());
-    preOrderTraversal(node->right.get());
+  std::cout << "Read-mostly table (" << kKeys << " keys):\n";
+
+  auto start = Clock::now();
+  {
+    BinaryTree<int, Balancing::RED_BLACK> inserted;
+    for (int key : sorted) inserted.insert(key);
   }
+  std::cout << "  build by insert: " << millis(Clock::now() - start) << " ms\n";
+
+  start = Clock::now();
+  const auto tree = BinaryTree<int, Balancing::RED_BLACK>::fromSorted(sorted);
+  std::cout << "  build fromSorted: " << millis(Clock::now() - start)
+            << " ms, height " << tree.height() << '\n';
+
+  start = Clock::now();
+  const FrozenTree<int> frozen(sorted);
+  std::cout << "  build frozen: " << millis(Clock::now() - start) << " ms\n";
 
-  static void postOrderTraversal(const Node<T>* node) {
-    if (!node) return;
-    postOrderTraversal(node->left.get());
-    postOrderTraversal(node->right.get());
-    std::cout << node->data << ' ';
+  size_t found = 0;
+  start = Clock::now();
+  for (int key : probes) {
+    if (tree.find(key)) ++found;
   }
+  std::cout << "  red-black find: " << per_probe(Clock::now() - start)
+            << " ns, found " << found << '\n';
 
-  static bool search(const T& value, const Node<T>* node) {
-    if (!node) return false;
-    if (value == node->data) return true;
-    if (value < node->data) return search(value, node->left.get());
-    return search(value, node->right.get());
+  found = 0;
+  start = Clock::now();
+  for (int key : probes) {
+    if (std::ranges::binary_search(sorted, key)) ++found;
   }
-};
+  std::cout << "  sorted array binary_search: "
+            << per_probe(Clock::now() - start) << " ns, found " << found
+            << '\n';
+
+  found = 0;
+  start = Clock::now();
+  for (int key : probes) {
+    if (frozen.contains(key)) ++found;
+  }
+  std::cout << "  eytzinger find: " << per_probe(Clock::now() - start)
+            << " ns, found " << found << '\n';
+}
 
 int main() {
   BinaryTree<int> bt;
@@ -105,5 +252,55 @@ int main() {
   std::cout << "Search 3: " << (bt.search(3) ? "Found" : "Not Found") << '\n';
   std::cout << "Search 4: " << (bt.search(4) ? "Found" : "Not Found") << '\n';
 
+  // Sorted insertion keeps a balanced tree shallow
+  BinaryTree<int, Balancing::RED_BLACK> rb;
+  BinaryTree<int, Balancing::AVL> avl;
+  for (int i = 1; i <= 7; ++i) {
+    rb.insert(i);
+    avl.insert(i);
+  }
+  std::cout << "Red-black pre-order after inserting 1..7: ";
+  rb.preOrderTraversal();
+  std::cout << "AVL pre-order after inserting 1..7: ";
+  avl.preOrderTraversal();
+
+  avl.erase(4);
+  std::cout << "AVL in-order after erasing 4: ";
+  avl.inOrderTraversal();
+
+  // Iterators, range views and order statistics
+  BinaryTree<int, Balancing::RED_BLACK> ordered;
+  for (int i = 0; i < 100; i += 3) ordered.insert(i);
+  std::cout << "Range [10, 30): ";
+  for (int value : ordered.range(10, 30)) std::cout << value << ' ';
+  std::cout << '\n';
+
+  constexpr size_t kPageSize = 5;
+  constexpr size_t kPage = 2;
+  std::cout << "Page " << kPage << " of " << kPageSize << ": ";
+  const auto page = std::ranges::subrange(ordered.select(kPage * kPageSize),
+                                          ordered.end()) |
+                    std::views::take(kPageSize);
+  for (int value : page) std::cout << value << ' ';
+  std::cout << '\n';
+
+  std::cout << "rank(50) = " << ordered.rank(50) << ", largest = "
+            << *std::prev(ordered.end()) << '\n';
+
+  BPlusTree<int, std::string_view> index;
+  index.insert(30, "thirty");
+  index.insert(10, "ten");
+  index.insert(20, "twenty");
+  index.insert(40, "forty");
+  std::cout << "B+-tree scan [15, 35): ";
+  index.scan(15, 35, [](int key, std::string_view name) {
+    std::cout << key << '=' << name << ' ';
+  });
+  std::cout << '\n';
+
+  benchmarkInsertOrders();
+  benchmarkOrderedIndex();
+  benchmarkReadMostly();
+
   return 0;
 }
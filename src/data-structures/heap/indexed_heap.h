@@ -0,0 +1,148 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <limits>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+// Addressable d-ary heap. Every element carries a caller-chosen id (a vertex,
+// a timer slot, ...) and a position map from id to heap slot, so an element
+// can be found, re-prioritized or removed in O(log n) without pushing
+// duplicates. Ids should be small and dense: the map is a vector indexed by
+// id. As in MaxHeap, the top is the greatest element under Compare.
+template <typename T, size_t Arity = 4, typename Compare = std::less<T>>
+class IndexedHeap {
+  static_assert(Arity >= 2, "a heap node needs at least two children");
+  static constexpr size_t kAbsent = std::numeric_limits<size_t>::max();
+
+ public:
+  struct Entry {
+    size_t id;
+    T value;
+  };
+
+  IndexedHeap() = default;
+  explicit IndexedHeap(Compare comp) : compare(std::move(comp)) {}
+
+  void push(size_t id, T value) {
+    if (contains(id)) throw std::invalid_argument("Id already in heap");
+    if (id >= position.size()) position.resize(id + 1, kAbsent);
+    heap.push_back({id, std::move(value)});
+    position[id] = heap.size() - 1;
+    siftUp(heap.size() - 1);
+  }
+
+  // Changes the value of id and restores the heap in whichever direction it
+  // moved.
+  void update_key(size_t id, T value) {
+    const size_t slot = slotOf(id);
+    const bool raised = compare(heap[slot].value, value);
+    heap[slot].value = std::move(value);
+    if (raised) {
+      siftUp(slot);
+    } else {
+      siftDown(slot);
+    }
+  }
+
+  void erase(size_t id) {
+    const size_t slot = slotOf(id);
+    removeAt(slot);
+  }
+
+  [[nodiscard]] bool contains(size_t id) const noexcept {
+    return id < position.size() && position[id] != kAbsent;
+  }
+
+  [[nodiscard]] const T& value(size_t id) const {
+    return heap[slotOf(id)].value;
+  }
+
+  [[nodiscard]] const Entry& top() const {
+    if (heap.empty()) throw std::runtime_error("Heap is empty");
+    return heap.front();
+  }
+
+  // Removes the top element and returns it by move.
+  Entry pop() {
+    if (heap.empty()) throw std::runtime_error("Heap is empty");
+    Entry top = std::move(heap.front());
+    removeAt(0);
+    return top;
+  }
+
+  [[nodiscard]] size_t size() const noexcept { return heap.size(); }
+  [[nodiscard]] bool empty() const noexcept { return heap.empty(); }
+
+  void clear() noexcept {
+    for (const Entry& entry : heap) position[entry.id] = kAbsent;
+    heap.clear();
+  }
+
+ private:
+  std::vector<Entry> heap;
+  std::vector<size_t> position;  // id -> slot in heap, or kAbsent
+  [[no_unique_address]] Compare compare;
+
+  size_t slotOf(size_t id) const {
+    if (!contains(id)) throw std::invalid_argument("Id not in heap");
+    return position[id];
+  }
+
+  // Fills the slot with the last entry and sifts that one whichever way it
+  // has to go.
+  void removeAt(size_t slot) {
+    position[heap[slot].id] = kAbsent;
+    if (slot + 1 == heap.size()) {
+      heap.pop_back();
+      return;
+    }
+    heap[slot] = std::move(heap.back());
+    heap.pop_back();
+    position[heap[slot].id] = slot;
+    if (slot > 0 && compare(heap[parent(slot)].value, heap[slot].value)) {
+      siftUp(slot);
+    } else {
+      siftDown(slot);
+    }
+  }
+
+  // Both sifts move entries into a hole and record every move in position.
+  void siftUp(size_t slot) {
+    Entry entry = std::move(heap[slot]);
+    while (slot > 0 && compare(heap[parent(slot)].value, entry.value)) {
+      place(slot, std::move(heap[parent(slot)]));
+      slot = parent(slot);
+    }
+    place(slot, std::move(entry));
+  }
+
+  void siftDown(size_t slot) {
+    Entry entry = std::move(heap[slot]);
+    const size_t size = heap.size();
+    while (true) {
+      const size_t first = Arity * slot + 1;
+      if (first >= size) break;
+      const size_t last = first + Arity < size ? first + Arity : size;
+      size_t best = first;
+      for (size_t child = first + 1; child < last; ++child) {
+        best = compare(heap[best].value, heap[child].value) ? child : best;
+      }
+      if (!compare(entry.value, heap[best].value)) break;
+      place(slot, std::move(heap[best]));
+      slot = best;
+    }
+    place(slot, std::move(entry));
+  }
+
+  void place(size_t slot, Entry&& entry) {
+    position[entry.id] = slot;
+    heap[slot] = std::move(entry);
+  }
+
+  [[nodiscard]] static size_t parent(size_t slot) noexcept {
+    return (slot - 1) / Arity;
+  }
+};
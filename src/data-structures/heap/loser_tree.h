@@ -0,0 +1,112 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <ranges>
+#include <span>
+#include <utility>
+#include <vector>
+
+// Merges k sorted runs into one sorted sequence with a tournament tree of
+// losers. Every inner node remembers the run that lost the match played
+// there, and the overall winner is kept aside. After the winner's run
+// advances, only its path to the root is replayed: log2(k) comparisons, each
+// against a single stored loser, where a binary heap of run heads needs up to
+// two comparisons per level. Ties go to the lower run index, so the merge is
+// stable.
+//
+// Iterate it with a range-for; it views the runs and does not copy them.
+template <typename T, typename Compare = std::less<T>>
+class KWayMerge {
+ public:
+  class Iterator {
+   public:
+    using iterator_category = std::input_iterator_tag;
+    using value_type = T;
+    using difference_type = std::ptrdiff_t;
+
+    Iterator() = default;
+    explicit Iterator(KWayMerge* owner) : merge(owner) {}
+
+    const T& operator*() const { return merge->front(); }
+    Iterator& operator++() {
+      merge->advance();
+      return *this;
+    }
+    void operator++(int) { merge->advance(); }
+    bool operator==(std::default_sentinel_t) const { return merge->empty(); }
+
+   private:
+    KWayMerge* merge = nullptr;
+  };
+
+  explicit KWayMerge(std::vector<std::span<const T>> sorted_runs,
+                     Compare comp = Compare())
+      : runs(std::move(sorted_runs)),
+        losers(runs.size(), 0),
+        compare(std::move(comp)) {
+    build();
+  }
+
+  [[nodiscard]] bool empty() const {
+    return runs.empty() || exhausted(winner);
+  }
+
+  [[nodiscard]] const T& front() const { return head(winner); }
+
+  // Takes the front element and replays the winner's path.
+  void advance() {
+    runs[winner] = runs[winner].subspan(1);
+    size_t candidate = winner;
+    for (size_t node = (candidate + runs.size()) / 2; node > 0; node /= 2) {
+      if (beats(losers[node], candidate)) std::swap(losers[node], candidate);
+    }
+    winner = candidate;
+  }
+
+  Iterator begin() { return Iterator(this); }
+  std::default_sentinel_t end() const { return {}; }
+
+ private:
+  // Leaves are runs 0..k-1 at tree positions k..2k-1; inner node n has
+  // children 2n and 2n + 1. A full tournament fills losers[1..k-1].
+  void build() {
+    const size_t k = runs.size();
+    if (k == 0) return;
+    std::vector<size_t> winners(2 * k);
+    for (size_t run = 0; run < k; ++run) winners[k + run] = run;
+    for (size_t node = k - 1; node > 0; --node) {
+      const size_t a = winners[2 * node];
+      const size_t b = winners[2 * node + 1];
+      const bool a_wins = beats(a, b);
+      winners[node] = a_wins ? a : b;
+      losers[node] = a_wins ? b : a;
+    }
+    winner = k == 1 ? 0 : winners[1];
+  }
+
+  [[nodiscard]] bool exhausted(size_t run) const {
+    return runs[run].empty();
+  }
+
+  [[nodiscard]] const T& head(size_t run) const {
+    return runs[run].front();
+  }
+
+  // Whether run a's head comes before run b's; exhausted runs always lose.
+  [[nodiscard]] bool beats(size_t a, size_t b) const {
+    if (exhausted(a)) return false;
+    if (exhausted(b)) return true;
+    if (compare(head(a), head(b))) return true;
+    if (compare(head(b), head(a))) return false;
+    return a < b;
+  }
+
+  std::vector<std::span<const T>> runs;  // unconsumed rest of each run
+  std::vector<size_t> losers;
+  size_t winner = 0;
+  [[no_unique_address]] Compare compare;
+};
+
+static_assert(std::ranges::input_range<KWayMerge<int>>);
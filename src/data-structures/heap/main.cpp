@@ -1,81 +1,324 @@
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
 #include <cstdlib>
+#include <functional>
 #include <iostream>
-#include <stdexcept>
+#include <queue>
+#include <random>
+#include <span>
+#include <string>
+#include <string_view>
+#include <thread>
 #include <utility>
 #include <vector>
 
-template <typename T>
-class MaxHeap {
- public:
-  MaxHeap() = default;
+#include "indexed_heap.h"
+#include "loser_tree.h"
+#include "max_heap.h"
+#include "pairing_heap.h"
+#include "top_k.h"
 
-  void insert(const T& value) {
-    data.emplace_back(value);
-    heapifyUp(data.size() - 1);
-  }
+struct Task {
+  std::string name;
+  int priority;
+};
 
-  void removeMax() {
-    if (data.empty()) return;
-    data[0] = data.back();
-    data.pop_back();
-    if (!data.empty()) heapifyDown(0);
+// Lower priority number runs first.
+struct RunsLater {
+  bool operator()(const Task& a, const Task& b) const {
+    return a.priority > b.priority;
   }
+};
 
-  [[nodiscard]] const T& getMax() const {
-    if (data.empty()) throw std::runtime_error("Heap is empty");
-    return data[0];
-  }
+template <typename Heap>
+void benchmarkHeap(std::string_view name, const std::vector<uint64_t>& keys) {
+  using Clock = std::chrono::steady_clock;
+  const auto millis = [](auto duration) {
+    return std::chrono::duration<double, std::milli>(duration).count();
+  };
 
-  void print() const {
-    for (const auto& value : data) {
-      std::cout << value << " ";
-    }
-    std::cout << "\n";
+  auto start = Clock::now();
+  Heap heap;
+  for (uint64_t key : keys) heap.push(key);
+  const auto pushed = Clock::now();
+  uint64_t checksum = 0;
+  while (!heap.empty()) {
+    checksum += heap.top();
+    heap.pop();
   }
+  const auto popped = Clock::now();
+  std::cout << "  " << name << ": push " << millis(pushed - start)
+            << " ms, pop " << millis(popped - pushed) << " ms (checksum "
+            << checksum << ")\n";
+}
+
+// Adapts MaxHeap to the std::priority_queue interface used above.
+template <size_t Arity>
+struct DaryHeap : MaxHeap<uint64_t, Arity> {
+  void push(uint64_t key) { this->insert(key); }
+  [[nodiscard]] uint64_t top() const { return this->getMax(); }
+};
+
+void benchmarkArity() {
+  constexpr size_t kKeys = 1'000'000;
+  std::mt19937_64 rng(42);
+  std::vector<uint64_t> keys(kKeys);
+  for (auto& key : keys) key = rng();
+
+  std::cout << "Push then pop " << kKeys << " random keys:\n";
+  benchmarkHeap<std::priority_queue<uint64_t>>("std::priority_queue", keys);
+  benchmarkHeap<DaryHeap<2>>("binary heap", keys);
+  benchmarkHeap<DaryHeap<4>>("4-ary heap", keys);
+  benchmarkHeap<DaryHeap<8>>("8-ary heap", keys);
+
+  using Clock = std::chrono::steady_clock;
+  auto start = Clock::now();
+  MaxHeap<uint64_t, 4> inserted;
+  for (uint64_t key : keys) inserted.insert(key);
+  const auto by_insert = Clock::now() - start;
+  start = Clock::now();
+  const MaxHeap<uint64_t, 4> floyd(keys);
+  const auto by_heapify = Clock::now() - start;
+  std::cout << "Build 4-ary heap: " << kKeys << " inserts "
+            << std::chrono::duration<double, std::milli>(by_insert).count()
+            << " ms, heapify "
+            << std::chrono::duration<double, std::milli>(by_heapify).count()
+            << " ms (same max: " << std::boolalpha
+            << (inserted.getMax() == floyd.getMax()) << ")\n";
+}
 
- private:
-  std::vector<T> data;
+// Adjacency lists in compressed form: the edges of v are
+// edges[offsets[v] .. offsets[v + 1]).
+struct Graph {
+  std::vector<size_t> offsets;
+  std::vector<std::pair<size_t, uint64_t>> edges;  // target, weight
+};
 
-  void heapifyUp(size_t index) {
-    while (index > 0 && data[parent(index)] < data[index]) {
-      std::swap(data[parent(index)], data[index]);
-      index = parent(index);
+Graph randomGraph(size_t vertices, size_t degree, std::mt19937_64& rng) {
+  std::uniform_int_distribution<size_t> target(0, vertices - 1);
+  std::uniform_int_distribution<uint64_t> weight(1, 1000);
+  Graph graph;
+  graph.offsets.reserve(vertices + 1);
+  graph.edges.reserve(vertices * degree);
+  for (size_t v = 0; v < vertices; ++v) {
+    graph.offsets.push_back(graph.edges.size());
+    for (size_t e = 0; e < degree; ++e) {
+      graph.edges.emplace_back(target(rng), weight(rng));
     }
   }
+  graph.offsets.push_back(graph.edges.size());
+  return graph;
+}
 
-  void heapifyDown(size_t index) {
-    while (true) {
-      size_t leftChild = left(index);
-      size_t rightChild = right(index);
-      size_t largestChild = index;
+constexpr uint64_t kUnreached = UINT64_MAX;
 
-      if (leftChild < data.size() && data[leftChild] > data[index]) {
-        largestChild = leftChild;
-      }
-      if (rightChild < data.size() && data[rightChild] > data[largestChild]) {
-        largestChild = rightChild;
+// The workaround the addressable heaps replace: push a duplicate on every
+// improvement and skip stale entries when they surface.
+std::vector<uint64_t> dijkstraLazy(const Graph& graph, size_t& peak) {
+  using Item = std::pair<uint64_t, size_t>;  // distance, vertex
+  std::vector<uint64_t> dist(graph.offsets.size() - 1, kUnreached);
+  std::priority_queue<Item, std::vector<Item>, std::greater<>> queue;
+  dist[0] = 0;
+  queue.emplace(0, 0);
+  peak = 1;
+  while (!queue.empty()) {
+    const auto [d, v] = queue.top();
+    queue.pop();
+    if (d != dist[v]) continue;
+    for (size_t e = graph.offsets[v]; e < graph.offsets[v + 1]; ++e) {
+      const auto [to, weight] = graph.edges[e];
+      if (d + weight < dist[to]) {
+        dist[to] = d + weight;
+        queue.emplace(dist[to], to);
       }
-      if (largestChild == index) {
-        break;
+    }
+    peak = std::max(peak, queue.size());
+  }
+  return dist;
+}
+
+// Heap is IndexedHeap or PairingHeap keyed by vertex, ordered so the
+// smallest distance is on top.
+template <typename Heap>
+std::vector<uint64_t> dijkstraIndexed(const Graph& graph, size_t& peak) {
+  std::vector<uint64_t> dist(graph.offsets.size() - 1, kUnreached);
+  Heap queue;
+  dist[0] = 0;
+  queue.push(0, 0);
+  peak = 1;
+  while (!queue.empty()) {
+    const auto [v, d] = queue.pop();
+    for (size_t e = graph.offsets[v]; e < graph.offsets[v + 1]; ++e) {
+      const auto [to, weight] = graph.edges[e];
+      if (d + weight >= dist[to]) continue;
+      if (queue.contains(to)) {
+        queue.update_key(to, d + weight);
+      } else {
+        queue.push(to, d + weight);
       }
+      dist[to] = d + weight;
+    }
+    peak = std::max(peak, queue.size());
+  }
+  return dist;
+}
+
+void benchmarkDijkstra() {
+  constexpr size_t kVertices = 200'000;
+  constexpr size_t kDegree = 8;
+  std::mt19937_64 rng(7);
+  const Graph graph = randomGraph(kVertices, kDegree, rng);
 
-      std::swap(data[index], data[largestChild]);
-      index = largestChild;
+  std::cout << "Dijkstra on " << kVertices << " vertices, "
+            << kVertices * kDegree << " edges:\n";
+  std::vector<uint64_t> reference;
+  const auto run = [&](std::string_view name, auto&& dijkstra) {
+    size_t peak = 0;
+    const auto start = std::chrono::steady_clock::now();
+    const std::vector<uint64_t> dist = dijkstra(graph, peak);
+    const std::chrono::duration<double, std::milli> elapsed =
+        std::chrono::steady_clock::now() - start;
+    if (reference.empty()) reference = dist;
+    std::cout << "  " << name << ": " << elapsed.count()
+              << " ms, peak heap size " << peak << ", same distances "
+              << std::boolalpha << (dist == reference) << '\n';
+  };
+  run("lazy std::priority_queue", dijkstraLazy);
+  run("indexed 4-ary heap",
+      dijkstraIndexed<IndexedHeap<uint64_t, 4, std::greater<>>>);
+  run("pairing heap", dijkstraIndexed<PairingHeap<uint64_t, std::greater<>>>);
+}
+
+// Timer wheel workload: most operations push a timer's deadline back, a few
+// fire the earliest one and re-arm it.
+template <typename Heap>
+double rescheduleTimers(size_t timers, size_t operations) {
+  std::mt19937_64 rng(3);
+  std::uniform_int_distribution<uint64_t> delay(1, 1'000'000);
+  std::uniform_int_distribution<size_t> pick(0, timers - 1);
+  Heap heap;
+  uint64_t now = 0;
+  for (size_t id = 0; id < timers; ++id) heap.push(id, delay(rng));
+
+  const auto start = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < operations; ++i) {
+    if (i % 10 == 0) {
+      const auto [id, deadline] = heap.pop();
+      now = deadline;
+      heap.push(id, now + delay(rng));
+    } else {
+      heap.update_key(pick(rng), now + delay(rng));
     }
   }
+  const std::chrono::duration<double, std::milli> elapsed =
+      std::chrono::steady_clock::now() - start;
+  return elapsed.count();
+}
+
+void benchmarkTimers() {
+  constexpr size_t kTimers = 100'000;
+  constexpr size_t kOperations = 2'000'000;
+  std::cout << "Rescheduling " << kTimers << " timers, " << kOperations
+            << " operations:\n";
+  std::cout << "  indexed 4-ary heap: "
+            << rescheduleTimers<IndexedHeap<uint64_t, 4, std::greater<>>>(
+                   kTimers, kOperations)
+            << " ms\n";
+  std::cout << "  pairing heap: "
+            << rescheduleTimers<PairingHeap<uint64_t, std::greater<>>>(
+                   kTimers, kOperations)
+            << " ms\n";
+}
+
+// Top 100 of 10M scores: every thread filters its share into a local
+// collector, then the collectors are merged.
+void benchmarkTopK() {
+  constexpr size_t kCandidates = 10'000'000;
+  constexpr size_t kK = 100;
+  std::vector<uint64_t> scores(kCandidates);
+  std::mt19937_64 rng(5);
+  for (auto& score : scores) score = rng();
 
-  [[nodiscard]] static size_t parent(size_t index) noexcept {
-    return (index - 1) / 2;
+  using Clock = std::chrono::steady_clock;
+  const auto millis = [](auto duration) {
+    return std::chrono::duration<double, std::milli>(duration).count();
+  };
+
+  auto start = Clock::now();
+  std::vector<uint64_t> copy = scores;
+  std::ranges::partial_sort(copy, copy.begin() + kK, std::greater<>());
+  copy.resize(kK);
+  const auto partial_sort_time = Clock::now() - start;
+
+  start = Clock::now();
+  const size_t threads = std::max(1u, std::thread::hardware_concurrency());
+  std::vector<TopK<uint64_t>> local(threads, TopK<uint64_t>(kK));
+  {
+    std::vector<std::jthread> workers;
+    const size_t chunk = (kCandidates + threads - 1) / threads;
+    for (size_t t = 0; t < threads; ++t) {
+      workers.emplace_back([&, t] {
+        const size_t first = std::min(kCandidates, t * chunk);
+        const size_t last = std::min(kCandidates, first + chunk);
+        for (size_t i = first; i < last; ++i) local[t].push(scores[i]);
+      });
+    }
   }
+  TopK<uint64_t> global(kK);
+  for (const auto& collector : local) global.merge(collector);
+  const auto top_k_time = Clock::now() - start;
 
-  [[nodiscard]] static size_t left(size_t index) noexcept {
-    return 2 * index + 1;
+  std::cout << "Top " << kK << " of " << kCandidates << ": partial_sort "
+            << millis(partial_sort_time) << " ms, " << threads
+            << " TopK collectors + merge " << millis(top_k_time)
+            << " ms, same result " << std::boolalpha
+            << (global.sorted() == copy) << '\n';
+}
+
+// Merging sorted runs: loser tree versus a binary heap of run heads.
+void benchmarkKWayMerge() {
+  constexpr size_t kRuns = 64;
+  constexpr size_t kRunLength = 100'000;
+  std::mt19937_64 rng(9);
+  std::vector<std::vector<uint64_t>> runs(kRuns);
+  for (auto& run : runs) {
+    run.resize(kRunLength);
+    for (auto& value : run) value = rng();
+    std::ranges::sort(run);
   }
 
-  [[nodiscard]] static size_t right(size_t index) noexcept {
-    return 2 * index + 2;
+  using Clock = std::chrono::steady_clock;
+  auto start = Clock::now();
+  uint64_t loser_checksum = 0;
+  KWayMerge<uint64_t> merge({runs.begin(), runs.end()});
+  for (uint64_t value : merge) loser_checksum = loser_checksum * 31 + value;
+  const std::chrono::duration<double, std::milli> loser_time =
+      Clock::now() - start;
+
+  start = Clock::now();
+  using Head = std::pair<uint64_t, size_t>;  // value, run
+  std::priority_queue<Head, std::vector<Head>, std::greater<>> heads;
+  std::vector<size_t> positions(kRuns, 0);
+  for (size_t run = 0; run < kRuns; ++run) heads.emplace(runs[run][0], run);
+  uint64_t heap_checksum = 0;
+  while (!heads.empty()) {
+    const auto [value, run] = heads.top();
+    heads.pop();
+    heap_checksum = heap_checksum * 31 + value;
+    if (++positions[run] < kRunLength) {
+      heads.emplace(runs[run][positions[run]], run);
+    }
   }
-};
+  const std::chrono::duration<double, std::milli> heap_time =
+      Clock::now() - start;
+
+  std::cout << "Merge " << kRuns << " runs of " << kRunLength
+            << ": loser tree " << loser_time.count() << " ms, binary heap "
+            << heap_time.count() << " ms, same output " << std::boolalpha
+            << (loser_checksum == heap_checksum) << '\n';
+}
 
 int main() {
   MaxHeap<int> heap;
@@ -94,5 +337,48 @@ int main() {
   heap.removeMax();
   heap.print();
 
+  // A 4-ary min-heap of tasks, built in O(n) and drained by moving out
+  MaxHeap<Task, 4, RunsLater> scheduler(std::vector<Task>{
+      {"compact", 5}, {"flush", 1}, {"gc", 9}, {"index", 3}});
+  scheduler.push_range(std::vector<Task>{{"reply", 0}, {"backup", 7}});
+  std::cout << "Run order: ";
+  while (!scheduler.empty()) {
+    const Task task = scheduler.pop();
+    std::cout << task.name << '(' << task.priority << ") ";
+  }
+  std::cout << '\n';
+
+  // Addressable heaps re-prioritize by id instead of pushing duplicates
+  IndexedHeap<int, 4, std::greater<>> deadlines;
+  deadlines.push(0, 30);
+  deadlines.push(1, 10);
+  deadlines.push(2, 20);
+  deadlines.update_key(0, 5);
+  deadlines.erase(2);
+  std::cout << "Earliest timer: " << deadlines.top().id << " at "
+            << deadlines.top().value << ", timer 2 pending: " << std::boolalpha
+            << deadlines.contains(2) << '\n';
+
+  TopK<int> best(3);
+  for (int score : {42, 7, 99, 13, 64, 88, 5}) best.push(score);
+  std::cout << "Top 3:";
+  for (int score : best.sorted()) std::cout << ' ' << score;
+  std::cout << '\n';
+
+  const std::vector<int> odd{1, 5, 9};
+  const std::vector<int> even{2, 4, 10, 12};
+  const std::vector<int> mixed{3, 6, 7};
+  std::cout << "Merged runs:";
+  for (int value : KWayMerge<int>({odd, even, mixed})) {
+    std::cout << ' ' << value;
+  }
+  std::cout << '\n';
+
+  benchmarkArity();
+  benchmarkDijkstra();
+  benchmarkTimers();
+  benchmarkTopK();
+  benchmarkKWayMerge();
+
   return EXIT_SUCCESS;
 }
@@ -0,0 +1,183 @@
+#pragma once
+
+#include <concepts>
+#include <cstddef>
+#include <functional>
+#include <iostream>
+#include <iterator>
+#include <ranges>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Implicit d-ary heap in a vector. The top is the greatest element under
+// Compare, so std::greater<T> turns it into a min-heap. Wider nodes make the
+// heap shallower: pushes move fewer elements and pops touch fewer cache lines,
+// since the children of a node are adjacent, at the cost of more comparisons
+// per level.
+template <typename T, size_t Arity = 2, typename Compare = std::less<T>>
+class MaxHeap {
+  static_assert(Arity >= 2, "a heap node needs at least two children");
+
+ public:
+  MaxHeap() = default;
+  explicit MaxHeap(Compare comp) : compare(std::move(comp)) {}
+
+  // Builds the heap from a range in O(n). Another MaxHeap is excluded, so
+  // copies go through the copy constructor and keep the comparator.
+  template <std::ranges::input_range R>
+    requires(!std::same_as<std::remove_cvref_t<R>, MaxHeap> &&
+             std::convertible_to<std::ranges::range_reference_t<R>, T>)
+  explicit MaxHeap(R&& range, Compare comp = Compare())
+      : data(std::ranges::begin(range), std::ranges::end(range)),
+        compare(std::move(comp)) {
+    heapify();
+  }
+
+  void insert(const T& value) {
+    data.push_back(value);
+    heapifyUp(data.size() - 1);
+  }
+
+  void insert(T&& value) {
+    data.push_back(std::move(value));
+    heapifyUp(data.size() - 1);
+  }
+
+  // Appends a range. Sifting each element up costs O(k log n), rebuilding
+  // with Floyd's method O(n + k), so large batches rebuild.
+  template <std::ranges::input_range R>
+    requires std::convertible_to<std::ranges::range_reference_t<R>, T>
+  void push_range(R&& range) {
+    const size_t old_size = data.size();
+    for (auto&& value : range) {
+      data.emplace_back(std::forward<decltype(value)>(value));
+    }
+    const size_t added = data.size() - old_size;
+    if (added > old_size / 2) {
+      heapify();
+    } else {
+      for (size_t i = old_size; i < data.size(); ++i) heapifyUp(i);
+    }
+  }
+
+  // Removes the top element and returns it by move.
+  T pop() {
+    if (data.empty()) throw std::runtime_error("Heap is empty");
+    T top = std::move(data.front());
+    if (data.size() > 1) {
+      T last = std::move(data.back());
+      data.pop_back();
+      sinkHoleToLeaf(0, std::move(last));
+    } else {
+      data.pop_back();
+    }
+    return top;
+  }
+
+  void removeMax() {
+    if (!data.empty()) pop();
+  }
+
+  // Replaces the top element with value in a single sift, cheaper than a
+  // pop followed by an insert.
+  void replaceMax(T value) {
+    if (data.empty()) throw std::runtime_error("Heap is empty");
+    siftDownHole(0, std::move(value));
+  }
+
+  [[nodiscard]] const T& getMax() const {
+    if (data.empty()) throw std::runtime_error("Heap is empty");
+    return data[0];
+  }
+
+  [[nodiscard]] size_t size() const noexcept { return data.size(); }
+  [[nodiscard]] bool empty() const noexcept { return data.empty(); }
+  void clear() noexcept { data.clear(); }
+
+  // The elements in heap order, not sorted.
+  [[nodiscard]] auto begin() const noexcept { return data.begin(); }
+  [[nodiscard]] auto end() const noexcept { return data.end(); }
+  void reserve(size_t capacity) { data.reserve(capacity); }
+
+  void print() const {
+    for (const auto& value : data) {
+      std::cout << value << " ";
+    }
+    std::cout << "\n";
+  }
+
+ private:
+  std::vector<T> data;
+  [[no_unique_address]] Compare compare;
+
+  // Floyd's method: sift down every inner node, starting from the last one.
+  // Most nodes are near the bottom and sift only a level or two, so the
+  // total work is O(n).
+  void heapify() {
+    if (data.size() < 2) return;
+    for (size_t i = parent(data.size() - 1) + 1; i-- > 0;) {
+      T value = std::move(data[i]);
+      siftDownHole(i, std::move(value));
+    }
+  }
+
+  // Moves parents down into the hole instead of swapping, one move per level.
+  void heapifyUp(size_t index) {
+    T value = std::move(data[index]);
+    while (index > 0 && compare(data[parent(index)], value)) {
+      data[index] = std::move(data[parent(index)]);
+      index = parent(index);
+    }
+    data[index] = std::move(value);
+  }
+
+  // Fills the hole at index with value, pulling the greatest child up while
+  // it beats value.
+  void siftDownHole(size_t index, T value) {
+    const size_t size = data.size();
+    while (true) {
+      const size_t first = firstChild(index);
+      if (first >= size) break;
+      const size_t last = first + Arity < size ? first + Arity : size;
+      size_t best = first;
+      for (size_t child = first + 1; child < last; ++child) {
+        best = compare(data[best], data[child]) ? child : best;
+      }
+      if (!compare(value, data[best])) break;
+      data[index] = std::move(data[best]);
+      index = best;
+    }
+    data[index] = std::move(value);
+  }
+
+  // Bottom-up variant for pop: the replacement comes from the last leaf and
+  // nearly always sinks back to the bottom, so walk the hole down without
+  // comparing against it, then sift it up the few levels it overshot. That
+  // saves one unpredictable comparison per level.
+  void sinkHoleToLeaf(size_t index, T value) {
+    const size_t size = data.size();
+    while (true) {
+      const size_t first = firstChild(index);
+      if (first >= size) break;
+      const size_t last = first + Arity < size ? first + Arity : size;
+      size_t best = first;
+      for (size_t child = first + 1; child < last; ++child) {
+        best = compare(data[best], data[child]) ? child : best;
+      }
+      data[index] = std::move(data[best]);
+      index = best;
+    }
+    data[index] = std::move(value);
+    heapifyUp(index);
+  }
+
+  [[nodiscard]] static size_t parent(size_t index) noexcept {
+    return (index - 1) / Arity;
+  }
+
+  [[nodiscard]] static size_t firstChild(size_t index) noexcept {
+    return Arity * index + 1;
+  }
+};
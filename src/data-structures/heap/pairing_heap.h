@@ -0,0 +1,161 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <limits>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+// Pairing heap with the same id-based interface as IndexedHeap. It is a
+// multiway tree where push and raising a key are O(1) melds and pop does all
+// the restructuring (O(log n) amortized). Nodes live in a vector indexed by
+// id and link to each other by index, so there is no allocation per push.
+template <typename T, typename Compare = std::less<T>>
+class PairingHeap {
+  static constexpr size_t kNone = std::numeric_limits<size_t>::max();
+
+  struct Node {
+    T value{};
+    size_t child = kNone;    // leftmost child
+    size_t sibling = kNone;  // next sibling to the right
+    size_t prev = kNone;     // left sibling, or parent for a leftmost child
+    bool present = false;
+  };
+
+ public:
+  struct Entry {
+    size_t id;
+    T value;
+  };
+
+  PairingHeap() = default;
+  explicit PairingHeap(Compare comp) : compare(std::move(comp)) {}
+
+  void push(size_t id, T value) {
+    if (contains(id)) throw std::invalid_argument("Id already in heap");
+    if (id >= nodes.size()) nodes.resize(id + 1);
+    nodes[id] = Node{std::move(value), kNone, kNone, kNone, true};
+    root = meld(root, id);
+    ++count;
+  }
+
+  // Raising a key cuts the subtree out and melds it with the root in O(1).
+  // Lowering one has to re-sort its children, so it is erase plus push.
+  void update_key(size_t id, T value) {
+    checkPresent(id);
+    if (compare(nodes[id].value, value)) {
+      nodes[id].value = std::move(value);
+      if (id != root) {
+        cut(id);
+        root = meld(root, id);
+      }
+    } else {
+      erase(id);
+      push(id, std::move(value));
+    }
+  }
+
+  void erase(size_t id) {
+    checkPresent(id);
+    if (id == root) {
+      root = combineChildren(id);
+    } else {
+      cut(id);
+      root = meld(root, combineChildren(id));
+    }
+    nodes[id].present = false;
+    --count;
+  }
+
+  [[nodiscard]] bool contains(size_t id) const noexcept {
+    return id < nodes.size() && nodes[id].present;
+  }
+
+  [[nodiscard]] const T& value(size_t id) const {
+    checkPresent(id);
+    return nodes[id].value;
+  }
+
+  [[nodiscard]] Entry top() const {
+    if (root == kNone) throw std::runtime_error("Heap is empty");
+    return {root, nodes[root].value};
+  }
+
+  // Removes the top element and returns it by move.
+  Entry pop() {
+    if (root == kNone) throw std::runtime_error("Heap is empty");
+    const size_t id = root;
+    Entry top{id, std::move(nodes[id].value)};
+    root = combineChildren(id);
+    nodes[id].present = false;
+    --count;
+    return top;
+  }
+
+  [[nodiscard]] size_t size() const noexcept { return count; }
+  [[nodiscard]] bool empty() const noexcept { return count == 0; }
+
+ private:
+  std::vector<Node> nodes;
+  std::vector<size_t> pairs;  // scratch for combineChildren
+  size_t root = kNone;
+  size_t count = 0;
+  [[no_unique_address]] Compare compare;
+
+  void checkPresent(size_t id) const {
+    if (!contains(id)) throw std::invalid_argument("Id not in heap");
+  }
+
+  // Links two detached trees: the loser becomes the winner's leftmost child.
+  size_t meld(size_t a, size_t b) {
+    if (a == kNone) return b;
+    if (b == kNone) return a;
+    if (compare(nodes[a].value, nodes[b].value)) std::swap(a, b);
+    Node& winner = nodes[a];
+    Node& loser = nodes[b];
+    loser.sibling = winner.child;
+    loser.prev = a;
+    if (winner.child != kNone) nodes[winner.child].prev = b;
+    winner.child = b;
+    return a;
+  }
+
+  // Unlinks id (with its subtree) from its parent's child list.
+  void cut(size_t id) {
+    Node& node = nodes[id];
+    Node& prev = nodes[node.prev];
+    if (prev.child == id) {
+      prev.child = node.sibling;
+    } else {
+      prev.sibling = node.sibling;
+    }
+    if (node.sibling != kNone) nodes[node.sibling].prev = node.prev;
+    node.sibling = kNone;
+    node.prev = kNone;
+  }
+
+  // Two-pass pairing: meld children in pairs left to right, then fold the
+  // pairs right to left. Returns the new subtree root.
+  size_t combineChildren(size_t id) {
+    size_t child = nodes[id].child;
+    nodes[id].child = kNone;
+    pairs.clear();
+    while (child != kNone) {
+      const size_t first = child;
+      const size_t second = nodes[first].sibling;
+      child = second == kNone ? kNone : nodes[second].sibling;
+      detach(first);
+      if (second != kNone) detach(second);
+      pairs.push_back(meld(first, second));
+    }
+    size_t result = kNone;
+    for (size_t i = pairs.size(); i-- > 0;) result = meld(pairs[i], result);
+    return result;
+  }
+
+  void detach(size_t id) {
+    nodes[id].sibling = kNone;
+    nodes[id].prev = kNone;
+  }
+};
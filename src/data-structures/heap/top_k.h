@@ -0,0 +1,76 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <utility>
+#include <vector>
+
+#include "max_heap.h"
+
+// Keeps the k greatest elements (under Compare) of a stream in O(k) memory.
+// Internally a MaxHeap with the order reversed, so its top is the weakest
+// element kept: a candidate that does not beat it is rejected with a single
+// comparison, which is the common case once the collector is full. Separate
+// collectors, e.g. one per thread, merge into one.
+template <typename T, typename Compare = std::less<T>>
+class TopK {
+  // Reverses Compare so the heap's top is the weakest kept element.
+  struct Weaker {
+    [[no_unique_address]] Compare compare;
+    bool operator()(const T& a, const T& b) const { return compare(b, a); }
+  };
+
+ public:
+  explicit TopK(size_t k, Compare comp = Compare())
+      : limit(k), compare(comp), heap(Weaker{std::move(comp)}) {
+    heap.reserve(k);
+  }
+
+  // Returns whether value was kept (it may still be evicted later).
+  bool push(const T& value) {
+    if (heap.size() < limit) {
+      heap.insert(value);
+      return true;
+    }
+    if (limit == 0 || !compare(heap.getMax(), value)) return false;
+    heap.replaceMax(value);
+    return true;
+  }
+
+  bool push(T&& value) {
+    if (heap.size() < limit) {
+      heap.insert(std::move(value));
+      return true;
+    }
+    if (limit == 0 || !compare(heap.getMax(), value)) return false;
+    heap.replaceMax(std::move(value));
+    return true;
+  }
+
+  // Folds another collector in; the result is the top k of both streams.
+  void merge(const TopK& other) {
+    for (const T& value : other.heap) push(value);
+  }
+
+  // The weakest element kept; anything not better is rejected once full().
+  [[nodiscard]] const T& threshold() const { return heap.getMax(); }
+
+  [[nodiscard]] size_t size() const noexcept { return heap.size(); }
+  [[nodiscard]] size_t capacity() const noexcept { return limit; }
+  [[nodiscard]] bool full() const noexcept { return heap.size() == limit; }
+
+  // The kept elements, best first.
+  [[nodiscard]] std::vector<T> sorted() const {
+    std::vector<T> result(heap.begin(), heap.end());
+    std::ranges::sort(result, [this](const T& a, const T& b) {
+      return compare(b, a);
+    });
+    return result;
+  }
+
+ private:
+  size_t limit;
+  [[no_unique_address]] Compare compare;
+  MaxHeap<T, 4, Weaker> heap;
+};
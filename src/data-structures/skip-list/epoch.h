@@ -0,0 +1,172 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+// Epoch-based memory reclamation. Readers pin the current global epoch for
+// the duration of a Guard; writers retire() unlinked objects instead of
+// deleting them. The global epoch only advances once every pinned thread has
+// seen it, so an object retired in epoch e is unreachable by anyone once the
+// epoch reaches e + 2 and can be freed.
+namespace epoch {
+
+namespace detail {
+
+inline constexpr uint64_t kIdle = ~uint64_t{0};
+inline constexpr size_t kMaxThreads = 128;
+inline constexpr size_t kReclaimEvery = 64;  // retirements between attempts
+
+struct Retired {
+  void* object;
+  void (*deleter)(void*);
+  uint64_t epoch;
+};
+
+// Each slot sits on its own cache line so pinning does not cause false
+// sharing between threads.
+struct alignas(64) Slot {
+  std::atomic<uint64_t> epoch{kIdle};
+  std::atomic<bool> in_use{false};
+};
+
+class Domain {
+ public:
+  static Domain& instance() {
+    static Domain domain;
+    return domain;
+  }
+
+  Domain(const Domain&) = delete;
+  Domain& operator=(const Domain&) = delete;
+
+  ~Domain() {
+    for (const Retired& retired : orphans_) retired.deleter(retired.object);
+  }
+
+  size_t acquireSlot() {
+    for (size_t i = 0; i < slots_.size(); ++i) {
+      if (!slots_[i].in_use.exchange(true)) return i;
+    }
+    throw std::runtime_error("epoch: too many threads");
+  }
+
+  // Objects a thread could not free before exiting are adopted by the
+  // domain and freed by whichever thread reclaims next.
+  void releaseSlot(size_t slot, std::vector<Retired>&& leftovers) {
+    {
+      std::scoped_lock lock(orphans_mutex_);
+      orphans_.insert(orphans_.end(), leftovers.begin(), leftovers.end());
+    }
+    slots_[slot].epoch.store(kIdle);
+    slots_[slot].in_use.store(false);
+  }
+
+  void pin(size_t slot) { slots_[slot].epoch.store(global_.load()); }
+  void unpin(size_t slot) {
+    slots_[slot].epoch.store(kIdle, std::memory_order_release);
+  }
+
+  [[nodiscard]] uint64_t current() const { return global_.load(); }
+
+  // Advances the global epoch if every pinned thread has observed it and
+  // returns the (possibly new) epoch.
+  uint64_t tryAdvance() {
+    uint64_t global = global_.load();
+    for (const Slot& slot : slots_) {
+      if (!slot.in_use.load()) continue;
+      const uint64_t pinned = slot.epoch.load();
+      if (pinned != kIdle && pinned != global) return global;
+    }
+    global_.compare_exchange_strong(global, global + 1);
+    return global_.load();
+  }
+
+  void reclaimOrphans(uint64_t global) {
+    std::unique_lock lock(orphans_mutex_, std::try_to_lock);
+    if (!lock || orphans_.empty()) return;
+    freeExpired(orphans_, global);
+  }
+
+  static void freeExpired(std::vector<Retired>& retired, uint64_t global) {
+    std::erase_if(retired, [global](const Retired& entry) {
+      if (entry.epoch + 2 > global) return false;
+      entry.deleter(entry.object);
+      return true;
+    });
+  }
+
+ private:
+  Domain() = default;
+
+  std::atomic<uint64_t> global_{0};
+  std::array<Slot, kMaxThreads> slots_{};
+  std::mutex orphans_mutex_;
+  std::vector<Retired> orphans_;
+};
+
+// Per-thread registration, created on the first Guard or retire().
+struct ThreadState {
+  Domain& domain = Domain::instance();
+  size_t slot = domain.acquireSlot();
+  size_t depth = 0;
+  std::vector<Retired> retired;
+
+  ThreadState() = default;
+  ThreadState(const ThreadState&) = delete;
+  ThreadState& operator=(const ThreadState&) = delete;
+
+  ~ThreadState() {
+    reclaim();
+    domain.releaseSlot(slot, std::move(retired));
+  }
+
+  void reclaim() {
+    const uint64_t global = domain.tryAdvance();
+    Domain::freeExpired(retired, global);
+    domain.reclaimOrphans(global);
+  }
+};
+
+inline ThreadState& threadState() {
+  thread_local ThreadState state;
+  return state;
+}
+
+}  // namespace detail
+
+// Pins the current epoch; nodes reachable while it lives stay allocated.
+// Guards nest, only the outermost one pins and unpins.
+class Guard {
+ public:
+  Guard() : state_(detail::threadState()) {
+    if (state_.depth++ == 0) state_.domain.pin(state_.slot);
+  }
+  ~Guard() {
+    if (--state_.depth == 0) state_.domain.unpin(state_.slot);
+  }
+  Guard(const Guard&) = delete;
+  Guard& operator=(const Guard&) = delete;
+
+ private:
+  detail::ThreadState& state_;
+};
+
+// Schedules object for deletion once no guard can still reference it. The
+// object must already be unreachable for new readers.
+template <typename T>
+void retire(T* object) {
+  detail::ThreadState& state = detail::threadState();
+  state.retired.push_back({object,
+                           [](void* erased) { delete static_cast<T*>(erased); },
+                           state.domain.current()});
+  if (state.retired.size() % detail::kReclaimEvery == 0) state.reclaim();
+}
+
+}  // namespace epoch
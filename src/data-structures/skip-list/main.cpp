@@ -0,0 +1,130 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <mutex>
+#include <random>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "binary_tree.h"
+#include "skip_list.h"
+
+// The single-lock baseline: every operation serializes on one mutex.
+class LockedTree {
+ public:
+  bool insert(int key, int /*value*/) {
+    std::scoped_lock lock(mutex_);
+    return tree_.insert(key);
+  }
+
+  bool erase(int key) {
+    std::scoped_lock lock(mutex_);
+    return tree_.erase(key);
+  }
+
+  [[nodiscard]] bool contains(int key) const {
+    std::scoped_lock lock(mutex_);
+    return tree_.search(key);
+  }
+
+  template <typename Fn>
+  void scan(int lo, int hi, Fn&& fn) const {
+    std::scoped_lock lock(mutex_);
+    for (int key : tree_.range(lo, hi)) fn(key, key);
+  }
+
+ private:
+  mutable std::mutex mutex_;
+  BinaryTree<int, Balancing::RED_BLACK> tree_;
+};
+
+// Mixed read-heavy workload: 80% lookups, 9% inserts, 9% erases and 2%
+// scans of 64 consecutive keys, over a key space that stays half full.
+template <typename Map>
+double runWorkload(size_t threads) {
+  constexpr int kKeySpace = 1 << 16;
+  constexpr size_t kOpsPerThread = 200'000;
+  constexpr int kScanWidth = 64;
+
+  Map map;
+  for (int key = 0; key < kKeySpace; key += 2) map.insert(key, key);
+  std::atomic<size_t> hits{0};  // consumes the reads so they are not elided
+
+  const auto start = std::chrono::steady_clock::now();
+  std::vector<std::jthread> workers;
+  for (size_t t = 0; t < threads; ++t) {
+    workers.emplace_back([&map, &hits, t] {
+      std::mt19937 rng(static_cast<uint32_t>(t));
+      std::uniform_int_distribution<int> key_dist(0, kKeySpace - 1);
+      std::uniform_int_distribution<int> op_dist(0, 99);
+      size_t sink = 0;
+      for (size_t i = 0; i < kOpsPerThread; ++i) {
+        const int key = key_dist(rng);
+        const int op = op_dist(rng);
+        if (op < 80) {
+          if (map.contains(key)) ++sink;
+        } else if (op < 89) {
+          map.insert(key, key);
+        } else if (op < 98) {
+          map.erase(key);
+        } else {
+          map.scan(key, key + kScanWidth, [&sink](int, int) { ++sink; });
+        }
+      }
+      hits.fetch_add(sink, std::memory_order_relaxed);
+    });
+  }
+  workers.clear();
+  const std::chrono::duration<double> elapsed =
+      std::chrono::steady_clock::now() - start;
+  return static_cast<double>(threads * kOpsPerThread) / elapsed.count() / 1e6;
+}
+
+void benchmarkThroughput() {
+  const size_t hardware = std::max(1u, std::thread::hardware_concurrency());
+  std::vector<size_t> thread_counts;
+  for (size_t threads = 1; threads < hardware; threads *= 2) {
+    thread_counts.push_back(threads);
+  }
+  thread_counts.push_back(hardware);
+
+  std::cout << "Throughput in Mops/s (80% find, 18% update, 2% scan):\n";
+  for (size_t threads : thread_counts) {
+    const double locked = runWorkload<LockedTree>(threads);
+    const double skip_list = runWorkload<ConcurrentSkipList<int, int>>(threads);
+    std::cout << "  " << threads << " threads: mutex + BinaryTree " << locked
+              << ", skip list " << skip_list << '\n';
+  }
+}
+
+int main() {
+  ConcurrentSkipList<int, std::string> map;
+
+  // Four writers fill interleaved keys concurrently.
+  std::vector<std::jthread> writers;
+  for (int w = 0; w < 4; ++w) {
+    writers.emplace_back([&map, w] {
+      for (int i = w; i < 40; i += 4) map.insert(i, "v" + std::to_string(i));
+    });
+  }
+  writers.clear();
+
+  map.erase(7);
+  map.erase(21);
+  std::cout << "find(12): " << map.find(12).value_or("missing") << '\n';
+  std::cout << "find(7): " << map.find(7).value_or("missing") << '\n';
+  std::cout << "scan [5, 25): ";
+  map.scan(5, 25, [](int key, const std::string& value) {
+    std::cout << key << '=' << value << ' ';
+  });
+  std::cout << '\n';
+
+  benchmarkThroughput();
+
+  return 0;
+}
@@ -0,0 +1,348 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "epoch.h"
+
+// Test-and-test-and-set lock that sleeps on the flag instead of spinning.
+class SpinLock {
+ public:
+  void lock() {
+    while (flag_.test_and_set(std::memory_order_acquire)) {
+      flag_.wait(true, std::memory_order_relaxed);
+    }
+  }
+  void unlock() {
+    flag_.clear(std::memory_order_release);
+    flag_.notify_one();
+  }
+
+ private:
+  std::atomic_flag flag_;
+};
+
+// Ordered map for concurrent use, built as a lazy skip list (Herlihy, Lev,
+// Luchangco and Shavit). find() takes no locks. insert() and erase() lock
+// only the predecessors they relink, after checking that the optimistic
+// search is still valid. Erased nodes are freed through epoch-based
+// reclamation, so readers never touch freed memory.
+//
+// A key is present when its node is linked at level 0 and not marked:
+// insert takes effect when it links level 0, erase when it sets the mark.
+// Values are immutable once inserted. Key and Value must be default
+// constructible because the head sentinel holds one of each.
+template <typename Key, typename Value>
+class ConcurrentSkipList {
+  static constexpr size_t kMaxLevel = 16;
+  static constexpr size_t kNotFound = kMaxLevel;
+
+  struct Node {
+    Key key{};
+    Value value{};
+    size_t top_level = kMaxLevel - 1;
+    std::atomic<bool> marked{false};
+    std::atomic<bool> fully_linked{false};
+    // Sequence lock over next[0] and marked: odd while the owner of lock is
+    // changing them, so scans can tell whether two reads saw the same state.
+    std::atomic<uint64_t> version{0};
+    mutable SpinLock lock;
+    std::array<std::atomic<Node*>, kMaxLevel> next{};
+
+    Node() = default;
+    Node(const Key& k, const Value& v, size_t level)
+        : key(k), value(v), top_level(level) {}
+  };
+
+  using Path = std::array<Node*, kMaxLevel>;
+
+ public:
+  ConcurrentSkipList() = default;
+  ConcurrentSkipList(const ConcurrentSkipList&) = delete;
+  ConcurrentSkipList& operator=(const ConcurrentSkipList&) = delete;
+
+  // Must not run concurrently with other operations.
+  ~ConcurrentSkipList() {
+    Node* node = head_.next[0].load();
+    while (node) {
+      Node* next = node->next[0].load();
+      delete node;
+      node = next;
+    }
+  }
+
+  // Returns false (and keeps the old value) if the key was already present.
+  bool insert(const Key& key, const Value& value) {
+    epoch::Guard guard;
+    const size_t top = randomLevel();
+    Path preds{};
+    Path succs{};
+    while (true) {
+      const size_t found = search(key, preds, succs);
+      if (found != kNotFound) {
+        if (!succs[found]->marked.load()) return false;
+        continue;  // being erased, wait until it is unlinked
+      }
+
+      size_t locked = 0;
+      bool valid = true;
+      for (size_t level = 0; valid && level <= top; ++level) {
+        Node* pred = preds[level];
+        Node* succ = succs[level];
+        if (level == 0 || pred != preds[level - 1]) pred->lock.lock();
+        locked = level;
+        valid = !pred->marked.load() && (!succ || !succ->marked.load()) &&
+                pred->next[level].load() == succ;
+      }
+      if (!valid) {
+        unlockPredecessors(preds, locked);
+        continue;
+      }
+
+      auto* node = new Node(key, value, top);
+      for (size_t level = 0; level <= top; ++level) {
+        node->next[level].store(succs[level], std::memory_order_relaxed);
+      }
+      writeLocked(preds[0], [&] { preds[0]->next[0].store(node); });
+      for (size_t level = 1; level <= top; ++level) {
+        preds[level]->next[level].store(node);
+      }
+      node->fully_linked.store(true);
+      unlockPredecessors(preds, top);
+      return true;
+    }
+  }
+
+  // Returns false if the key was not present.
+  bool erase(const Key& key) {
+    epoch::Guard guard;
+    Node* victim = nullptr;
+    Path preds{};
+    Path succs{};
+    while (true) {
+      const size_t found = search(key, preds, succs);
+      if (!victim) {
+        if (found == kNotFound) return false;
+        Node* candidate = succs[found];
+        // Only a fully linked node found at its top level can be unlinked
+        // from every level; anything else is still being inserted.
+        if (!candidate->fully_linked.load() ||
+            candidate->top_level != found || candidate->marked.load()) {
+          if (candidate->marked.load()) return false;
+          continue;
+        }
+        candidate->lock.lock();
+        if (candidate->marked.load()) {
+          candidate->lock.unlock();
+          return false;
+        }
+        writeLocked(candidate, [&] { candidate->marked.store(true); });
+        victim = candidate;
+      }
+
+      const size_t top = victim->top_level;
+      size_t locked = 0;
+      bool valid = true;
+      for (size_t level = 0; valid && level <= top; ++level) {
+        Node* pred = preds[level];
+        if (level == 0 || pred != preds[level - 1]) pred->lock.lock();
+        locked = level;
+        valid = !pred->marked.load() && pred->next[level].load() == victim;
+      }
+      if (!valid) {
+        unlockPredecessors(preds, locked);
+        continue;
+      }
+
+      for (size_t level = top; level >= 1; --level) {
+        preds[level]->next[level].store(victim->next[level].load());
+      }
+      writeLocked(preds[0],
+                  [&] { preds[0]->next[0].store(victim->next[0].load()); });
+      victim->lock.unlock();
+      unlockPredecessors(preds, top);
+      epoch::retire(victim);
+      return true;
+    }
+  }
+
+  [[nodiscard]] std::optional<Value> find(const Key& key) const {
+    epoch::Guard guard;
+    const Node* pred = &head_;
+    for (size_t level = kMaxLevel; level-- > 0;) {
+      const Node* curr = pred->next[level].load(std::memory_order_acquire);
+      while (curr && curr->key < key) {
+        pred = curr;
+        curr = curr->next[level].load(std::memory_order_acquire);
+      }
+      if (curr && !(key < curr->key)) {
+        if (curr->marked.load()) return std::nullopt;
+        return curr->value;
+      }
+    }
+    return std::nullopt;
+  }
+
+  [[nodiscard]] bool contains(const Key& key) const {
+    return find(key).has_value();
+  }
+
+  // Calls fn(key, value) for every key in [lo, hi) as of a single instant.
+  // The level-0 chain is read twice; if no node's version changed in
+  // between, nothing in the range changed either, and the first read is an
+  // atomic snapshot. Under heavy writes it falls back to locking the range.
+  template <typename Fn>
+  void scan(const Key& lo, const Key& hi, Fn&& fn) const {
+    std::vector<std::pair<Key, Value>> snapshot;
+    {
+      epoch::Guard guard;
+      std::vector<Seen> first;
+      std::vector<Seen> second;
+      bool consistent = false;
+      for (int attempt = 0; !consistent && attempt < kOptimisticScans;
+           ++attempt) {
+        consistent = collect(lo, hi, first) && collect(lo, hi, second) &&
+                     first == second;
+      }
+      while (!consistent) consistent = collectLocked(lo, hi, first);
+
+      for (const Seen& seen : first) {
+        if (!seen.marked && seen.node != &head_ && !(seen.node->key < lo)) {
+          snapshot.emplace_back(seen.node->key, seen.node->value);
+        }
+      }
+    }
+    for (const auto& [key, value] : snapshot) fn(key, value);
+  }
+
+ private:
+  static constexpr int kOptimisticScans = 8;
+
+  // One consistent read of a node during a scan.
+  struct Seen {
+    const Node* node;
+    uint64_t version;
+    const Node* next;
+    bool marked;
+    bool operator==(const Seen&) const = default;
+  };
+
+  // Top-down search filling the predecessor and successor at every level.
+  // Returns the highest level at which key was found, or kNotFound.
+  size_t search(const Key& key, Path& preds, Path& succs) {
+    size_t found = kNotFound;
+    Node* pred = &head_;
+    for (size_t level = kMaxLevel; level-- > 0;) {
+      Node* curr = pred->next[level].load(std::memory_order_acquire);
+      while (curr && curr->key < key) {
+        pred = curr;
+        curr = curr->next[level].load(std::memory_order_acquire);
+      }
+      if (found == kNotFound && curr && !(key < curr->key)) found = level;
+      preds[level] = pred;
+      succs[level] = curr;
+    }
+    return found;
+  }
+
+  // The last node before lo at level 0, or the head.
+  const Node* predecessor(const Key& lo) const {
+    const Node* pred = &head_;
+    for (size_t level = kMaxLevel; level-- > 0;) {
+      const Node* curr = pred->next[level].load(std::memory_order_acquire);
+      while (curr && curr->key < lo) {
+        pred = curr;
+        curr = curr->next[level].load(std::memory_order_acquire);
+      }
+    }
+    return pred;
+  }
+
+  // Reads next[0] and marked of node under its sequence lock.
+  static Seen read(const Node* node) {
+    while (true) {
+      const uint64_t version = node->version.load(std::memory_order_acquire);
+      if (version % 2 == 0) {
+        const Node* next = node->next[0].load(std::memory_order_acquire);
+        const bool marked = node->marked.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (node->version.load(std::memory_order_relaxed) == version) {
+          return {node, version, next, marked};
+        }
+      }
+      std::this_thread::yield();
+    }
+  }
+
+  // Walks level 0 from the predecessor of lo to the last node below hi.
+  // Fails if the predecessor was erased: its frozen next pointer would miss
+  // keys inserted after its real predecessor.
+  bool collect(const Key& lo, const Key& hi, std::vector<Seen>& out) const {
+    out.clear();
+    Seen seen = read(predecessor(lo));
+    if (seen.marked) return false;
+    out.push_back(seen);
+    while (seen.next && seen.next->key < hi) {
+      seen = read(seen.next);
+      out.push_back(seen);
+    }
+    return true;
+  }
+
+  // Collects, then locks the collected nodes from the highest key down (the
+  // order writers use) and checks that none changed. While they are locked
+  // nothing can be linked into or unlinked from the range.
+  bool collectLocked(const Key& lo, const Key& hi,
+                     std::vector<Seen>& out) const {
+    if (!collect(lo, hi, out)) return false;
+    for (auto it = out.rbegin(); it != out.rend(); ++it) {
+      it->node->lock.lock();
+    }
+    bool unchanged = true;
+    for (const Seen& seen : out) {
+      unchanged = unchanged && read(seen.node) == seen;
+    }
+    for (const Seen& seen : out) seen.node->lock.unlock();
+    return unchanged;
+  }
+
+  // Changes next[0] or marked of a locked node inside its sequence lock.
+  template <typename Write>
+  static void writeLocked(Node* node, Write&& write) {
+    node->version.fetch_add(1, std::memory_order_acq_rel);
+    write();
+    node->version.fetch_add(1, std::memory_order_release);
+  }
+
+  static void unlockPredecessors(const Path& preds, size_t highest) {
+    for (size_t level = 0; level <= highest; ++level) {
+      if (level == 0 || preds[level] != preds[level - 1]) {
+        preds[level]->lock.unlock();
+      }
+    }
+  }
+
+  // Geometric level with p = 1/4 from a per-thread xorshift generator.
+  static size_t randomLevel() {
+    thread_local uint64_t state =
+        0x9E3779B97F4A7C15ull ^
+        std::hash<std::thread::id>{}(std::this_thread::get_id());
+    state ^= state << 13;
+    state ^= state >> 7;
+    state ^= state << 17;
+    const auto level = static_cast<size_t>(
+        std::countr_zero(state | (uint64_t{1} << 62)) / 2);
+    return std::min(level, kMaxLevel - 1);
+  }
+
+  mutable Node head_;
+};
@@ -1,14 +1,42 @@
 #include <algorithm>
+#include <atomic>
+#include <bit>
 #include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <deque>
 #include <expected>
+#include <filesystem>
+#include <format>
 #include <functional>
+#include <future>
+#include <limits>
 #include <memory>
+#include <mutex>
+#include <optional>
 #include <print>
+#include <queue>
 #include <ranges>
 #include <source_location>
+#include <span>
+#include <stop_token>
 #include <string>
+#include <string_view>
+#include <system_error>
 #include <thread>
+#include <unordered_map>
+#include <type_traits>
 #include <utility>
+#include <vector>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
 
 using namespace std::chrono_literals;
 
@@ -47,6 +75,106 @@ concept ValidatableCommand = requires(T t) {
   { t.cancel() } -> std::same_as<void>;
 };
 
+// Compact binary encoding used by the command journal. Sizes and counts are
+// LEB128 varints, other values are copied as they are laid out in memory.
+class BinaryWriter {
+ public:
+  template <typename T>
+    requires std::is_trivially_copyable_v<T>
+  void write(const T& value) {
+    const auto offset = buffer_.size();
+    buffer_.resize(offset + sizeof(T));
+    std::memcpy(buffer_.data() + offset, &value, sizeof(T));
+  }
+
+  void writeVarint(uint64_t value) {
+    while (value >= 0x80) {
+      buffer_.push_back(static_cast<char>((value & 0x7f) | 0x80));
+      value >>= 7;
+    }
+    buffer_.push_back(static_cast<char>(value));
+  }
+
+  void writeBytes(std::string_view bytes) {
+    writeVarint(bytes.size());
+    buffer_.append(bytes);
+  }
+
+  [[nodiscard]] const std::string& data() const noexcept { return buffer_; }
+  void clear() noexcept { buffer_.clear(); }
+
+ private:
+  std::string buffer_;
+};
+
+// Reading past the end leaves the reader in a failed state and returns
+// value-initialized results, so callers only need to check ok() at the end.
+class BinaryReader {
+ public:
+  explicit BinaryReader(std::string_view data) : data_(data) {}
+
+  template <typename T>
+    requires std::is_trivially_copyable_v<T>
+  T read() {
+    T value{};
+    if (sizeof(T) > data_.size() - offset_) {
+      failed_ = true;
+      return value;
+    }
+    std::memcpy(&value, data_.data() + offset_, sizeof(T));
+    offset_ += sizeof(T);
+    return value;
+  }
+
+  uint64_t readVarint() {
+    uint64_t value = 0;
+    for (unsigned shift = 0; shift < 64; shift += 7) {
+      if (offset_ >= data_.size()) break;
+      const auto byte = static_cast<uint8_t>(data_[offset_++]);
+      value |= uint64_t{byte & 0x7fu} << shift;
+      if ((byte & 0x80) == 0) return value;
+    }
+    failed_ = true;
+    return 0;
+  }
+
+  std::string_view readBytes() {
+    const auto size = readVarint();
+    if (size > data_.size() - offset_) {
+      failed_ = true;
+      return {};
+    }
+    auto bytes = data_.substr(offset_, size);
+    offset_ += size;
+    return bytes;
+  }
+
+  [[nodiscard]] bool ok() const noexcept { return !failed_; }
+
+ private:
+  std::string_view data_;
+  size_t offset_ = 0;
+  bool failed_ = false;
+};
+
+// Commands that can be written to a CommandJournal. Besides their parameters
+// they serialize whatever they captured on execute, so that a recovered
+// history can still be undone.
+template <typename T>
+concept SerializableCommand = requires(const T t, BinaryWriter& out) {
+  { T::kTypeId } -> std::convertible_to<uint32_t>;
+  { t.serialize(out) } -> std::same_as<void>;
+};
+
+// Memory locations a command reads and writes. Commands whose resources do
+// not conflict may run concurrently inside a BulkCommand. An exclusive command
+// conflicts with every other command.
+struct CommandResources {
+  std::vector<const void*> reads{};
+  std::vector<const void*> writes{};
+  bool exclusive = false;
+};
+
 class Command {
  public:
   Command(std::string_view name = "Unnamed Command",
@@ -80,17 +208,55 @@ class Command {
   [[nodiscard]] virtual CommandState getState() const noexcept {
     return state_;
   }
+  // May be called from any thread while the command is executing.
   virtual void cancel() {
-    if (state_ == CommandState::EXECUTING) {
-      state_ = CommandState::CANCELLED;
-    }
+    auto expected = CommandState::EXECUTING;
+    state_.compare_exchange_strong(expected, CommandState::CANCELLED);
   }
   [[nodiscard]] constexpr auto getLocation() const noexcept {
     return location_;
   }
+  // Approximate number of bytes this command keeps alive while it sits in the
+  // undo/redo history. Commands holding large payloads should override it.
+  [[nodiscard]] virtual size_t getMemoryFootprint() const noexcept {
+    return sizeof(Command) + name_.capacity();
+  }
+  // Identifies the state a command mutates. Asynchronous commands with the
+  // same target are executed one at a time, in submission order. nullptr means
+  // the command may touch anything, so it runs alone, after every command
+  // submitted before it and before every command submitted after it.
+  [[nodiscard]] virtual const void* getTarget() const noexcept {
+    return nullptr;
+  }
+  // Defaults to writing getTarget(), or to exclusive access if there is none.
+  [[nodiscard]] virtual CommandResources getResources() const {
+    if (const void* target = getTarget()) {
+      return {.writes = {target}};
+    }
+    return {.exclusive = true};
+  }
+  void setStopToken(std::stop_token token) noexcept {
+    stop_token_ = std::move(token);
+  }
+  // Non-zero for commands that model SerializableCommand.
+  [[nodiscard]] virtual uint32_t getTypeId() const noexcept { return 0; }
+  virtual void serialize(BinaryWriter& /*out*/) const {}
 
  protected:
+  // Copies what observers look at: name, location, state and timings.
+  Command(const Command& other)
+      : start_time_(other.start_time_),
+        end_time_(other.end_time_),
+        name_(other.name_),
+        state_(other.getState()),
+        location_(other.location_) {}
+
   void setState(CommandState state) noexcept { state_ = state; }
+  // Long-running commands should poll this and bail out with
+  // CommandError::CANCELLED, leaving their target untouched.
+  [[nodiscard]] bool isCancellationRequested() const noexcept {
+    return state_ == CommandState::CANCELLED || stop_token_.stop_requested();
+  }
   void begin() {
     state_ = CommandState::EXECUTING;
     start_time_ = std::chrono::steady_clock::now();
@@ -104,10 +270,21 @@ class Command {
   std::chrono::steady_clock::time_point start_time_{};
   std::chrono::steady_clock::time_point end_time_{};
   std::string name_;
-  CommandState state_ = CommandState::IDLE;
+  std::atomic<CommandState> state_ = CommandState::IDLE;
   std::source_location location_;
+  std::stop_token stop_token_;
 };
 
+// Writes a command together with its type id and name, the framing expected
+// by CommandRegistry::readCommand().
+void writeCommand(BinaryWriter& out, const Command& cmd) {
+  out.writeVarint(cmd.getTypeId());
+  out.writeBytes(cmd.getName());
+  BinaryWriter payload;
+  cmd.serialize(payload);
+  out.writeBytes(payload.data());
+}
+
 class MoveCommand : public Command {
  public:
   MoveCommand(int& x, int& y, int new_x, int new_y,
@@ -145,6 +322,30 @@ class MoveCommand : public Command {
     return {};
   }
 
+  [[nodiscard]] const void* getTarget() const noexcept override { return &x_; }
+  [[nodiscard]] CommandResources getResources() const override {
+    return {.writes = {&x_, &y_}};
+  }
+
+  static constexpr uint32_t kTypeId = 1;
+  [[nodiscard]] uint32_t getTypeId() const noexcept override { return kTypeId; }
+  void serialize(BinaryWriter& out) const override {
+    out.write(new_x_);
+    out.write(new_y_);
+    out.write(old_x_);
+    out.write(old_y_);
+  }
+  static std::shared_ptr<MoveCommand> deserialize(BinaryReader& in, int& x,
+                                                  int& y,
+                                                  std::string_view name) {
+    const auto new_x = in.read<int>();
+    const auto new_y = in.read<int>();
+    auto cmd = std::make_shared<MoveCommand>(x, y, new_x, new_y, name);
+    cmd->old_x_ = in.read<std::optional<int>>();
+    cmd->old_y_ = in.read<std::optional<int>>();
+    return cmd;
+  }
+
  private:
   int& x_;
   int& y_;
@@ -162,8 +363,15 @@ class ToggleCommand : public Command {
   CommandResult<void> execute() override {
     if (!canExecute()) return std::unexpected(CommandError::INVALID_STATE);
     begin();
+    // Simulate slow work, checking for cancellation along the way.
+    for (auto waited = 0ms; waited < 1s; waited += 10ms) {
+      if (isCancellationRequested()) {
+        setState(CommandState::CANCELLED);
+        return std::unexpected(CommandError::CANCELLED);
+      }
+      std::this_thread::sleep_for(10ms);
+    }
     old_state_ = value_;
-    std::this_thread::sleep_for(1s);
     value_ = !value_;
     end();
     return {};
@@ -175,9 +383,24 @@ class ToggleCommand : public Command {
     return {};
   }
 
+  [[nodiscard]] const void* getTarget() const noexcept override {
+    return &value_;
+  }
+
+  static constexpr uint32_t kTypeId = 2;
+  [[nodiscard]] uint32_t getTypeId() const noexcept override { return kTypeId; }
+  void serialize(BinaryWriter& out) const override { out.write(old_state_); }
+  static std::shared_ptr<ToggleCommand> deserialize(BinaryReader& in,
+                                                    bool& value,
+                                                    std::string_view name) {
+    auto cmd = std::make_shared<ToggleCommand>(value, name);
+    cmd->old_state_ = in.read<bool>();
+    return cmd;
+  }
+
  private:
   bool& value_;
-  bool old_state_;
+  bool old_state_ = false;
 };
 
 class RotationCommand : public Command {
@@ -204,12 +427,245 @@ class RotationCommand : public Command {
     return {};
   }
 
+  [[nodiscard]] const void* getTarget() const noexcept override {
+    return &angle_;
+  }
+
+  static constexpr uint32_t kTypeId = 3;
+  [[nodiscard]] uint32_t getTypeId() const noexcept override { return kTypeId; }
+  void serialize(BinaryWriter& out) const override {
+    out.write(new_angle_);
+    out.write(old_angle_);
+  }
+  static std::shared_ptr<RotationCommand> deserialize(BinaryReader& in,
+                                                      float& angle,
+                                                      std::string_view name) {
+    auto cmd = std::make_shared<RotationCommand>(angle, in.read<float>(), name);
+    cmd->old_angle_ = in.read<std::optional<float>>();
+    return cmd;
+  }
+
  private:
   float& angle_;
   float new_angle_;
   std::optional<float> old_angle_;
 };
 
+// PackBits run-length encoding: a control byte n in [0, 127] is followed by
+// n + 1 literal bytes, a control byte n in [129, 255] repeats the next byte
+// 257 - n times. Worst case overhead is one byte per 128 bytes of input.
+std::string packBits(std::string_view input) {
+  std::string output;
+  output.reserve(input.size() / 2 + 1);
+  size_t i = 0;
+  while (i < input.size()) {
+    size_t run = 1;
+    while (i + run < input.size() && run < 128 &&
+           input[i + run] == input[i]) {
+      ++run;
+    }
+    if (run >= 3) {
+      output.push_back(static_cast<char>(257 - run));
+      output.push_back(input[i]);
+      i += run;
+      continue;
+    }
+
+    size_t literal_end = i;
+    while (literal_end < input.size() && literal_end - i < 128) {
+      if (literal_end + 2 < input.size() &&
+          input[literal_end] == input[literal_end + 1] &&
+          input[literal_end] == input[literal_end + 2]) {
+        break;
+      }
+      ++literal_end;
+    }
+    output.push_back(static_cast<char>(literal_end - i - 1));
+    output.append(input.substr(i, literal_end - i));
+    i = literal_end;
+  }
+  return output;
+}
+
+std::string unpackBits(std::string_view input, size_t expected_size = 0) {
+  std::string output;
+  output.reserve(expected_size);
+  size_t i = 0;
+  while (i < input.size()) {
+    const auto control = static_cast<uint8_t>(input[i++]);
+    if (control < 128) {
+      output.append(input.substr(i, size_t{control} + 1));
+      i += size_t{control} + 1;
+    } else if (control > 128 && i < input.size()) {
+      output.append(257 - size_t{control}, input[i++]);
+    }
+  }
+  return output;
+}
+
+// Stores successive states of a large document as compressed deltas against
+// periodic keyframes. A snapshot only keeps the bytes that differ from its
+// keyframe, and a keyframe is released once no snapshot refers to it, so
+// evicting old commands from the history frees their keyframes as well.
+// A store is not thread-safe, use one per document.
+class SnapshotStore {
+  // Keyframes are shared by many snapshots and outlive the one that created
+  // them, so they are counted by the store for as long as they exist.
+  struct Keyframe {
+    std::string compressed;
+    size_t size;
+    std::shared_ptr<std::atomic<size_t>> live_bytes;
+    ~Keyframe() { *live_bytes -= compressed.capacity(); }
+  };
+
+ public:
+  class Snapshot {
+   public:
+    // Only the delta; the keyframe is counted by the store.
+    [[nodiscard]] size_t getMemoryFootprint() const noexcept {
+      return sizeof(Snapshot) + middle_.capacity();
+    }
+
+   private:
+    friend class SnapshotStore;
+    std::shared_ptr<const Keyframe> keyframe_;
+    size_t prefix_ = 0;  // bytes shared with the start of the keyframe
+    size_t suffix_ = 0;  // bytes shared with the end of the keyframe
+    size_t size_ = 0;
+    std::string middle_;  // packBits encoded bytes between prefix and suffix
+  };
+
+  explicit SnapshotStore(size_t keyframe_interval = 16)
+      : keyframe_interval_(keyframe_interval) {}
+
+  // Bytes of every keyframe still alive, plus the uncompressed copy of the
+  // current one. Safe to call from any thread.
+  [[nodiscard]] size_t getMemoryFootprint() const noexcept {
+    return *live_bytes_;
+  }
+
+  [[nodiscard]] std::shared_ptr<const Snapshot> capture(
+      std::string_view state) {
+    auto snapshot = std::make_shared<Snapshot>();
+    snapshot->size_ = state.size();
+
+    if (keyframe_ && captures_since_keyframe_ < keyframe_interval_) {
+      const std::string_view base = keyframe_raw_;
+      const size_t limit = std::min(base.size(), state.size());
+      size_t prefix = 0;
+      while (prefix < limit && base[prefix] == state[prefix]) ++prefix;
+      size_t suffix = 0;
+      while (suffix < limit - prefix &&
+             base[base.size() - 1 - suffix] ==
+                 state[state.size() - 1 - suffix]) {
+        ++suffix;
+      }
+
+      // A delta covering most of the document is no cheaper than a keyframe.
+      const size_t changed = state.size() - prefix - suffix;
+      if (changed <= state.size() / 2) {
+        snapshot->keyframe_ = keyframe_;
+        snapshot->prefix_ = prefix;
+        snapshot->suffix_ = suffix;
+        snapshot->middle_ = packBits(state.substr(prefix, changed));
+        snapshot->middle_.shrink_to_fit();
+        ++captures_since_keyframe_;
+        return snapshot;
+      }
+    }
+
+    auto compressed = packBits(state);
+    compressed.shrink_to_fit();
+    *live_bytes_ += compressed.capacity();
+    keyframe_ = std::make_shared<const Keyframe>(
+        Keyframe{.compressed = std::move(compressed),
+                 .size = state.size(),
+                 .live_bytes = live_bytes_});
+    *live_bytes_ -= keyframe_raw_.capacity();
+    keyframe_raw_.assign(state);
+    *live_bytes_ += keyframe_raw_.capacity();
+    captures_since_keyframe_ = 1;
+    snapshot->keyframe_ = keyframe_;
+    snapshot->prefix_ = state.size();
+    return snapshot;
+  }
+
+  [[nodiscard]] static std::string restore(const Snapshot& snapshot) {
+    const std::string base =
+        unpackBits(snapshot.keyframe_->compressed, snapshot.keyframe_->size);
+    std::string state;
+    state.reserve(snapshot.size_);
+    state.append(base, 0, snapshot.prefix_);
+    state.append(unpackBits(snapshot.middle_));
+    state.append(base, base.size() - snapshot.suffix_, snapshot.suffix_);
+    return state;
+  }
+
+ private:
+  size_t keyframe_interval_;
+  size_t captures_since_keyframe_ = 0;
+  std::shared_ptr<const Keyframe> keyframe_;
+  std::string keyframe_raw_;  // uncompressed copy of the current keyframe
+  // Shared with the keyframes, which may outlive the store.
+  std::shared_ptr<std::atomic<size_t>> live_bytes_ =
+      std::make_shared<std::atomic<size_t>>(0);
+};
+
+// Applies an arbitrary edit to a large document. Instead of holding on to full
+// copies of the document, the before and after states are kept as snapshots.
+class EditDocumentCommand : public Command {
+ public:
+  EditDocumentCommand(std::string& document, SnapshotStore& store,
+                      std::function<void(std::string&)> edit,
+                      std::string_view name = "Unnamed Edit Document Command")
+      : Command(name),
+        document_(document),
+        store_(store),
+        edit_(std::move(edit)) {}
+
+  CommandResult<void> execute() override {
+    if (!canExecute()) return std::unexpected(CommandError::INVALID_STATE);
+
+    begin();
+    if (after_) {
+      // Redo: the edit has already been recorded.
+      document_ = SnapshotStore::restore(*after_);
+    } else {
+      before_ = store_.capture(document_);
+      edit_(document_);
+      after_ = store_.capture(document_);
+      edit_ = nullptr;
+    }
+    end();
+    return {};
+  }
+
+  CommandResult<void> undo() override {
+    if (!canUndo()) return std::unexpected(CommandError::INVALID_STATE);
+    if (before_) {
+      document_ = SnapshotStore::restore(*before_);
+    }
+    return {};
+  }
+
+  [[nodiscard]] size_t getMemoryFootprint() const noexcept override {
+    return sizeof(EditDocumentCommand) + getName().size() +
+           (before_ ? before_->getMemoryFootprint() : 0) +
+           (after_ ? after_->getMemoryFootprint() : 0);
+  }
+
+  [[nodiscard]] const void* getTarget() const noexcept override {
+    return &document_;
+  }
+
+ private:
+  std::string& document_;
+  SnapshotStore& store_;
+  std::function<void(std::string&)> edit_;
+  std::shared_ptr<const SnapshotStore::Snapshot> before_;
+  std::shared_ptr<const SnapshotStore::Snapshot> after_;
+};
+
 class BulkCommand : public Command {
   std::vector<std::shared_ptr<Command>> commands;
 
@@ -226,6 +682,9 @@ class BulkCommand : public Command {
                     std::ranges::end(cmds));
   }
 
+  // Children are grouped into waves by their declared resources and the
+  // children of a wave run in parallel. If one of them fails, every child that
+  // already executed is undone in reverse wave order.
   CommandResult<void> execute() override {
     if (!canExecute()) return std::unexpected(CommandError::INVALID_STATE);
     if (auto result = validate(); !result) {
@@ -233,13 +692,21 @@ class BulkCommand : public Command {
     }
 
     begin();
-    for (const auto& cmd : commands) {
-      if (auto result = cmd->execute(); !result) {
-        for (auto it = commands.rbegin(); it != commands.rend() && *it != cmd;
-             ++it) {
-          (*it)->undo();
+    buildWaves();
+    executed_.assign(commands.size(), 0);
+    std::atomic<CommandError> error{};
+    for (const auto& wave : waves_) {
+      const bool succeeded = forEachParallel(wave, [&](size_t i) {
+        if (auto result = commands[i]->execute(); !result) {
+          error = result.error();
+          return false;
         }
-        return std::unexpected(result.error());
+        executed_[i] = 1;
+        return true;
+      });
+      if (!succeeded) {
+        undoWaves([this](size_t i) { return executed_[i] != 0; });
+        return std::unexpected(error.load());
       }
     }
     end();
@@ -248,9 +715,11 @@ class BulkCommand : public Command {
 
   CommandResult<void> undo() override {
     if (!canUndo()) return std::unexpected(CommandError::INVALID_STATE);
-    for (const auto& cmd : commands | std::views::reverse) {
-      cmd->undo();
+    if (waves_.empty()) {
+      // Restored from a journal checkpoint without being executed.
+      buildWaves();
     }
+    undoWaves([](size_t) { return true; });
     return {};
   }
 
@@ -261,6 +730,170 @@ class BulkCommand : public Command {
                ? CommandResult<void>{}
                : std::unexpected(CommandError::VALIDATION_FAILED);
   }
+
+  [[nodiscard]] size_t getMemoryFootprint() const noexcept override {
+    size_t bytes = Command::getMemoryFootprint() +
+                   commands.capacity() * sizeof(std::shared_ptr<Command>);
+    for (const auto& cmd : commands) {
+      bytes += cmd->getMemoryFootprint();
+    }
+    return bytes;
+  }
+
+  // A group is serializable when all of its children are.
+  static constexpr uint32_t kTypeId = 4;
+  [[nodiscard]] uint32_t getTypeId() const noexcept override {
+    return std::ranges::all_of(
+               commands, [](const auto& cmd) { return cmd->getTypeId() != 0; })
+               ? kTypeId
+               : 0;
+  }
+  void serialize(BinaryWriter& out) const override {
+    out.writeVarint(commands.size());
+    for (const auto& cmd : commands) {
+      writeCommand(out, *cmd);
+    }
+  }
+
+  [[nodiscard]] CommandResources getResources() const override {
+    CommandResources resources;
+    for (const auto& cmd : commands) {
+      auto child = cmd->getResources();
+      resources.exclusive = resources.exclusive || child.exclusive;
+      resources.reads.insert(resources.reads.end(), child.reads.begin(),
+                             child.reads.end());
+      resources.writes.insert(resources.writes.end(), child.writes.begin(),
+                              child.writes.end());
+    }
+    return resources;
+  }
+
+ private:
+  // Assigns every child to the earliest wave that comes after all earlier
+  // children it conflicts with: readers after the last writer, writers after
+  // the last writer and all readers of the same resource.
+  void buildWaves() {
+    waves_.clear();
+    // Earliest wave a later reader / writer of a resource may be placed in.
+    std::unordered_map<const void*, size_t> after_write;
+    std::unordered_map<const void*, size_t> after_read;
+    size_t after_exclusive = 0;
+
+    for (size_t i = 0; i < commands.size(); ++i) {
+      const auto resources = commands[i]->getResources();
+      size_t wave = after_exclusive;
+      if (resources.exclusive) {
+        wave = waves_.size();
+      } else {
+        for (const void* r : resources.reads) {
+          if (auto it = after_write.find(r); it != after_write.end()) {
+            wave = std::max(wave, it->second);
+          }
+        }
+        for (const void* r : resources.writes) {
+          if (auto it = after_write.find(r); it != after_write.end()) {
+            wave = std::max(wave, it->second);
+          }
+          if (auto it = after_read.find(r); it != after_read.end()) {
+            wave = std::max(wave, it->second);
+          }
+        }
+      }
+
+      if (wave == waves_.size()) {
+        waves_.emplace_back();
+      }
+      waves_[wave].push_back(i);
+
+      for (const void* r : resources.reads) {
+        auto& next = after_read[r];
+        next = std::max(next, wave + 1);
+      }
+      for (const void* r : resources.writes) {
+        after_write[r] = wave + 1;
+      }
+      if (resources.exclusive) {
+        after_exclusive = wave + 1;
+      }
+    }
+  }
+
+  template <typename Predicate>
+  void undoWaves(Predicate should_undo) {
+    for (const auto& wave : waves_ | std::views::reverse) {
+      forEachParallel(wave, [&](size_t i) {
+        if (should_undo(i)) {
+          commands[i]->undo();
+        }
+        return true;
+      });
+    }
+  }
+
+  // Calls fn for every index of the wave, spreading large waves over several
+  // threads. Stops handing out work once fn returns false.
+  template <typename Fn>
+  static bool forEachParallel(const std::vector<size_t>& wave, Fn fn) {
+    constexpr size_t kMinChildrenPerThread = 256;
+    constexpr size_t kChunkSize = 32;
+    const size_t num_threads =
+        std::min<size_t>(std::thread::hardware_concurrency(),
+                         wave.size() / kMinChildrenPerThread);
+    if (num_threads <= 1) {
+      return std::ranges::all_of(wave, fn);
+    }
+
+    std::atomic<size_t> next{0};
+    std::atomic<bool> failed{false};
+    {
+      std::vector<std::jthread> threads;
+      threads.reserve(num_threads);
+      for (size_t t = 0; t < num_threads; ++t) {
+        threads.emplace_back([&] {
+          while (!failed) {
+            const size_t first = next.fetch_add(kChunkSize);
+            if (first >= wave.size()) return;
+            const size_t last = std::min(first + kChunkSize, wave.size());
+            for (size_t k = first; k < last; ++k) {
+              if (!fn(wave[k])) {
+                failed = true;
+                return;
+              }
+            }
+          }
+        });
+      }
+    }
+    return !failed;
+  }
+
+  std::vector<std::vector<size_t>> waves_;
+  // Not std::vector<bool>, children of one wave set their flags concurrently.
+  std::vector<char> executed_;
+};
+
+// Frozen copy of a command's name, state and timings. Batched observers get
+// one of these instead of the live command, whose timings a later undo or
+// redo may rewrite while the dispatcher thread reads them.
+class CommandSnapshot final : public Command {
+ public:
+  explicit CommandSnapshot(const Command& cmd) : Command(cmd) {}
+
+  CommandResult<void> execute() override {
+    return std::unexpected(CommandError::INVALID_STATE);
+  }
+  CommandResult<void> undo() override {
+    return std::unexpected(CommandError::INVALID_STATE);
+  }
+  [[nodiscard]] bool canExecute() const override { return false; }
+  [[nodiscard]] bool canUndo() const override { return false; }
+};
+
+struct CommandEvent {
+  enum class Kind : uint8_t { EXECUTED, UNDONE, REDONE };
+  Kind kind = Kind::EXECUTED;
+  // A CommandSnapshot taken when the event was published.
+  std::shared_ptr<const Command> command;
 };
 
 class CommandObserver {
@@ -268,30 +901,708 @@ class CommandObserver {
   virtual void onCommandExecuted(const Command& cmd) = 0;
   virtual void onCommandUndone(const Command& cmd) = 0;
   virtual void onCommandRedone(const Command& cmd) = 0;
+  // Called instead of the functions above when notifications are batched.
+  // Override to amortize per-event costs such as I/O over the whole batch.
+  virtual void onCommandBatch(std::span<const CommandEvent> events) {
+    for (const auto& event : events) {
+      switch (event.kind) {
+        case CommandEvent::Kind::EXECUTED:
+          onCommandExecuted(*event.command);
+          break;
+        case CommandEvent::Kind::UNDONE:
+          onCommandUndone(*event.command);
+          break;
+        case CommandEvent::Kind::REDONE:
+          onCommandRedone(*event.command);
+          break;
+      }
+    }
+  }
   virtual ~CommandObserver() = default;
 };
 
 class CommandLogger : public CommandObserver {
  public:
   void onCommandExecuted(const Command& cmd) override {
-    std::println("Command '{}' executed in {}ms", cmd.getName(),
-                 cmd.getDuration().count());
+    std::println("{}", format(CommandEvent::Kind::EXECUTED, cmd));
   }
   void onCommandUndone(const Command& cmd) override {
-    std::println("Command '{}' undone in {}ms", cmd.getName(),
-                 cmd.getDuration().count());
+    std::println("{}", format(CommandEvent::Kind::UNDONE, cmd));
   }
   void onCommandRedone(const Command& cmd) override {
-    std::println("Command '{}' redone in {}ms", cmd.getName(),
-                 cmd.getDuration().count());
+    std::println("{}", format(CommandEvent::Kind::REDONE, cmd));
   }
+  // One write for the whole batch instead of one per command.
+  void onCommandBatch(std::span<const CommandEvent> events) override {
+    std::string lines;
+    for (const auto& event : events) {
+      lines += format(event.kind, *event.command);
+      lines += '\n';
+    }
+    std::print("{}", lines);
+  }
+
+ private:
+  static std::string format(CommandEvent::Kind kind, const Command& cmd) {
+    constexpr std::string_view kVerbs[] = {"executed", "undone", "redone"};
+    return std::format("Command '{}' {} in {}ms", cmd.getName(),
+                       kVerbs[static_cast<size_t>(kind)],
+                       cmd.getDuration().count());
+  }
+};
+
+// Delivers command notifications to observers in batches on a background
+// thread. Publishing an event only claims a slot in a bounded lock-free
+// multi-producer ring (Vyukov's queue), so command latency does not depend on
+// the number or speed of the observers. When the ring is full, publishers
+// wait for the dispatcher rather than drop events.
+class NotificationDispatcher {
+ public:
+  NotificationDispatcher(
+      std::vector<std::shared_ptr<CommandObserver>> observers, size_t capacity)
+      : observers_(std::move(observers)),
+        slots_(std::bit_ceil(std::max<size_t>(capacity, 2))),
+        mask_(slots_.size() - 1) {
+    for (size_t i = 0; i < slots_.size(); ++i) {
+      slots_[i].sequence.store(i, std::memory_order_relaxed);
+    }
+    thread_ = std::jthread([this](std::stop_token st) { dispatchLoop(st); });
+  }
+
+  ~NotificationDispatcher() {
+    thread_.request_stop();
+    wake();
+  }
+
+  NotificationDispatcher(const NotificationDispatcher&) = delete;
+  NotificationDispatcher& operator=(const NotificationDispatcher&) = delete;
+
+  void addObserver(std::shared_ptr<CommandObserver> observer) {
+    std::lock_guard lock(observers_mutex_);
+    observers_.push_back(std::move(observer));
+  }
+
+  void publish(CommandEvent event) {
+    while (!tryPush(event)) {
+      wake();
+      std::this_thread::yield();
+    }
+    // Pairs with the fence in dispatchLoop: either the dispatcher sees the
+    // new event before going to sleep, or we see that it sleeps.
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (sleeping_.load(std::memory_order_relaxed)) {
+      wake();
+    }
+  }
+
+  // Blocks until every event published so far has been delivered.
+  void flush() {
+    const size_t target = enqueue_pos_.load(std::memory_order_acquire);
+    wake();
+    size_t delivered = delivered_.load(std::memory_order_acquire);
+    while (delivered < target) {
+      delivered_.wait(delivered, std::memory_order_acquire);
+      delivered = delivered_.load(std::memory_order_acquire);
+    }
+  }
+
+ private:
+  static constexpr size_t kMaxBatch = 256;
+
+  struct Slot {
+    std::atomic<size_t> sequence;
+    CommandEvent event;
+  };
+
+  bool tryPush(CommandEvent& event) {
+    size_t pos = enqueue_pos_.load(std::memory_order_relaxed);
+    while (true) {
+      Slot& slot = slots_[pos & mask_];
+      const size_t sequence = slot.sequence.load(std::memory_order_acquire);
+      if (sequence == pos) {
+        if (enqueue_pos_.compare_exchange_weak(pos, pos + 1,
+                                               std::memory_order_relaxed)) {
+          slot.event = std::move(event);
+          slot.sequence.store(pos + 1, std::memory_order_release);
+          return true;
+        }
+      } else if (sequence < pos) {
+        return false;  // the slot still holds an event from the last lap
+      } else {
+        pos = enqueue_pos_.load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+  // Single consumer, so the dequeue position needs no synchronization.
+  bool tryPop(CommandEvent& event) {
+    Slot& slot = slots_[dequeue_pos_ & mask_];
+    if (slot.sequence.load(std::memory_order_acquire) != dequeue_pos_ + 1) {
+      return false;
+    }
+    event = std::move(slot.event);
+    slot.sequence.store(dequeue_pos_ + slots_.size(),
+                        std::memory_order_release);
+    ++dequeue_pos_;
+    return true;
+  }
+
+  void wake() {
+    wake_epoch_.fetch_add(1, std::memory_order_release);
+    wake_epoch_.notify_one();
+  }
+
+  void dispatchLoop(std::stop_token st) {
+    std::vector<CommandEvent> batch;
+    batch.reserve(kMaxBatch);
+    std::vector<std::shared_ptr<CommandObserver>> observers;
+    while (true) {
+      CommandEvent event;
+      while (batch.size() < kMaxBatch && tryPop(event)) {
+        batch.push_back(std::move(event));
+      }
+
+      if (!batch.empty()) {
+        {
+          std::lock_guard lock(observers_mutex_);
+          observers = observers_;
+        }
+        for (const auto& observer : observers) {
+          observer->onCommandBatch(batch);
+        }
+        delivered_.fetch_add(batch.size(), std::memory_order_release);
+        delivered_.notify_all();
+        batch.clear();
+        continue;
+      }
+      if (st.stop_requested()) return;
+
+      const auto epoch = wake_epoch_.load(std::memory_order_acquire);
+      sleeping_.store(true, std::memory_order_relaxed);
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      const bool empty =
+          slots_[dequeue_pos_ & mask_].sequence.load(
+              std::memory_order_acquire) != dequeue_pos_ + 1;
+      if (empty && !st.stop_requested()) {
+        wake_epoch_.wait(epoch, std::memory_order_acquire);
+      }
+      sleeping_.store(false, std::memory_order_relaxed);
+    }
+  }
+
+  std::mutex observers_mutex_;
+  std::vector<std::shared_ptr<CommandObserver>> observers_;
+  std::vector<Slot> slots_;
+  const size_t mask_;
+  alignas(64) std::atomic<size_t> enqueue_pos_{0};
+  alignas(64) size_t dequeue_pos_ = 0;
+  alignas(64) std::atomic<size_t> delivered_{0};
+  std::atomic<uint32_t> wake_epoch_{0};
+  std::atomic<bool> sleeping_{false};
+  std::jthread thread_;
+};
+
+// Thread pool that runs tasks with the same key one at a time, in submission
+// order (a strand per key), while tasks with different keys run in parallel.
+// A task without a key is exclusive: it starts once every task submitted
+// before it has finished, and tasks submitted after it wait until it is done.
+class CommandExecutor {
+ public:
+  explicit CommandExecutor(
+      size_t num_threads = std::max(1u, std::thread::hardware_concurrency())) {
+    workers_.reserve(num_threads);
+    for (size_t i = 0; i < num_threads; ++i) {
+      workers_.emplace_back([this](std::stop_token st) { workerLoop(st); });
+    }
+  }
+
+  ~CommandExecutor() {
+    for (auto& worker : workers_) {
+      worker.request_stop();
+    }
+    condition_.notify_all();
+  }
+
+  CommandExecutor(const CommandExecutor&) = delete;
+  CommandExecutor& operator=(const CommandExecutor&) = delete;
+
+  void submit(const void* key, std::function<void()> task) {
+    size_t ready = 0;
+    {
+      std::lock_guard lock(mutex_);
+      backlog_.push_back({key, std::move(task)});
+      ready = admitBacklog();
+    }
+    wakeWorkers(ready);
+  }
+
+  // Blocks until every task submitted so far has finished. Returns at once
+  // when called from one of the tasks, which would otherwise wait for itself.
+  void waitIdle() {
+    if (current_ == this) return;
+    std::unique_lock lock(mutex_);
+    idle_.wait(lock, [this] { return active_ == 0 && backlog_.empty(); });
+  }
+
+ private:
+  struct Task {
+    const void* key;
+    std::function<void()> run;
+  };
+
+  // Moves tasks from the front of the backlog to the ready queue, or behind
+  // the running task of their strand, until one has to wait: an exclusive
+  // task for every admitted task to finish, any task for a running exclusive
+  // one. Returns the number of tasks made ready. Expects mutex_ to be held.
+  size_t admitBacklog() {
+    size_t ready = 0;
+    while (!backlog_.empty() && !exclusive_running_) {
+      Task& task = backlog_.front();
+      if (task.key == nullptr) {
+        if (active_ > 0) break;
+        exclusive_running_ = true;
+        ready_.push(std::move(task));
+        ++ready;
+      } else if (auto it = strands_.find(task.key); it != strands_.end()) {
+        // A task for this key is queued or running, wait behind it.
+        it->second.push_back(std::move(task.run));
+      } else {
+        strands_.try_emplace(task.key);
+        ready_.push(std::move(task));
+        ++ready;
+      }
+      ++active_;
+      backlog_.pop_front();
+    }
+    return ready;
+  }
+
+  void wakeWorkers(size_t ready) {
+    if (ready == 1) {
+      condition_.notify_one();
+    } else if (ready > 1) {
+      condition_.notify_all();
+    }
+  }
+
+  void workerLoop(std::stop_token st) {
+    current_ = this;
+    while (true) {
+      Task task;
+      {
+        std::unique_lock lock(mutex_);
+        condition_.wait(lock, st, [this] { return !ready_.empty(); });
+        // Drain queued work before shutting down so no future is abandoned.
+        // Tasks still in the backlog wait for a running task, whose worker
+        // admits them when it finishes.
+        if (ready_.empty()) return;
+        task = std::move(ready_.front());
+        ready_.pop();
+      }
+      task.run();
+      finish(task.key);
+    }
+  }
+
+  void finish(const void* key) {
+    size_t ready = 0;
+    {
+      std::lock_guard lock(mutex_);
+      --active_;
+      if (key == nullptr) {
+        exclusive_running_ = false;
+      } else if (auto it = strands_.find(key); it->second.empty()) {
+        strands_.erase(it);
+      } else {
+        ready_.push({key, std::move(it->second.front())});
+        it->second.pop_front();
+        ++ready;
+      }
+      ready += admitBacklog();
+      if (active_ == 0 && backlog_.empty()) {
+        idle_.notify_all();
+      }
+    }
+    wakeWorkers(ready);
+  }
+
+  // The executor whose worker runs on this thread, if any.
+  static inline thread_local const CommandExecutor* current_ = nullptr;
+
+  std::mutex mutex_;
+  std::condition_variable_any condition_;
+  std::condition_variable_any idle_;
+  // Submitted tasks not yet admitted, in submission order.
+  std::deque<Task> backlog_;
+  std::queue<Task> ready_;
+  // Tasks waiting for the running task of the same key to finish.
+  std::unordered_map<const void*, std::deque<std::function<void()>>> strands_;
+  // Admitted tasks that have not finished: ready, running or in a strand.
+  size_t active_ = 0;
+  bool exclusive_running_ = false;
+  std::vector<std::jthread> workers_;
+};
+
+// Maps journal type ids back to commands. Factories bind the deserialized
+// parameters to the live state the command operates on.
+class CommandRegistry {
+ public:
+  using Factory = std::function<std::shared_ptr<Command>(BinaryReader&,
+                                                         std::string_view)>;
+
+  CommandRegistry() {
+    factories_[BulkCommand::kTypeId] = [this](BinaryReader& in,
+                                              std::string_view name)
+        -> std::shared_ptr<Command> {
+      auto bulk = std::make_shared<BulkCommand>(name);
+      const auto count = in.readVarint();
+      for (uint64_t i = 0; i < count && in.ok(); ++i) {
+        auto child = readCommand(in);
+        if (!child) return nullptr;
+        bulk->addCommand(std::move(child));
+      }
+      return bulk;
+    };
+  }
+
+  template <SerializableCommand T, typename F>
+    requires std::invocable<F, BinaryReader&, std::string_view>
+  void registerType(F factory) {
+    factories_[T::kTypeId] = std::move(factory);
+  }
+
+  // Reads a command framed by writeCommand(). Returns nullptr for unknown
+  // types and malformed input.
+  std::shared_ptr<Command> readCommand(BinaryReader& in) const {
+    const auto type_id = in.readVarint();
+    const auto name = in.readBytes();
+    BinaryReader payload(in.readBytes());
+    auto it = factories_.find(type_id);
+    if (!in.ok() || it == factories_.end()) return nullptr;
+    auto cmd = it->second(payload, name);
+    return payload.ok() ? cmd : nullptr;
+  }
+
+ private:
+  std::unordered_map<uint64_t, Factory> factories_;
+};
+
+// Append-only binary log of executed, undone and redone commands. Records are
+// buffered and written by a background thread, one write and one fsync per
+// batch (group commit). A checkpoint stores the application state and the
+// serialized history in a fresh log that atomically replaces the old one, so
+// recovery only has to replay the records written after it.
+//
+// File layout: "CJNL" followed by records of
+//   [u32 payload size][u32 FNV-1a of kind + payload][u8 kind][payload].
+// A torn record at the end (crash during a write) is dropped on recovery.
+class CommandJournal {
+ public:
+  enum class RecordKind : uint8_t {
+    EXECUTED = 1,  // payload: writeCommand()
+    UNDONE,
+    REDONE,
+    CHECKPOINT  // payload: state bytes, undo stack, redo stack
+  };
+
+  struct Record {
+    RecordKind kind;
+    std::string payload;
+  };
+
+  using StateSaver = std::function<void(BinaryWriter&)>;
+  using StateLoader = std::function<void(BinaryReader&)>;
+
+  explicit CommandJournal(std::filesystem::path path,
+                          std::chrono::milliseconds group_commit_window = 5ms)
+      : path_(std::move(path)), group_commit_window_(group_commit_window) {
+    if (!std::filesystem::exists(path_)) {
+      writeFile(path_, {});
+    }
+    openForAppend();
+    flusher_ = std::jthread([this](std::stop_token st) { flushLoop(st); });
+  }
+
+  ~CommandJournal() {
+    flusher_.request_stop();
+    condition_.notify_all();
+    flusher_.join();
+    if (file_) std::fclose(file_);
+  }
+
+  CommandJournal(const CommandJournal&) = delete;
+  CommandJournal& operator=(const CommandJournal&) = delete;
+
+  [[nodiscard]] CommandRegistry& registry() noexcept { return registry_; }
+
+  // Enables checkpoints every checkpoint_interval records. The saver writes the
+  // application state, the loader restores it during recovery.
+  void setStateHandlers(StateSaver saver, StateLoader loader,
+                        size_t checkpoint_interval = 1000) {
+    std::lock_guard lock(mutex_);
+    state_saver_ = std::move(saver);
+    state_loader_ = std::move(loader);
+    checkpoint_interval_ = checkpoint_interval;
+  }
+
+  // Queues a record and returns its sequence number. The record is durable
+  // once sync() with that number (or a later one) has returned.
+  uint64_t append(RecordKind kind, std::string_view payload = {}) {
+    uint64_t sequence = 0;
+    {
+      std::lock_guard lock(mutex_);
+      appendRecord(pending_, kind, payload);
+      ++records_since_checkpoint_;
+      sequence = ++last_sequence_;
+    }
+    condition_.notify_one();
+    return sequence;
+  }
+
+  // Blocks until every record appended so far is on disk.
+  void sync() {
+    std::unique_lock lock(mutex_);
+    const auto target = last_sequence_;
+    flush_requested_ = true;
+    condition_.notify_all();
+    durable_.wait(lock, [&] { return durable_sequence_ >= target; });
+  }
+
+  [[nodiscard]] bool checkpointDue() const {
+    std::lock_guard lock(mutex_);
+    return state_saver_ && records_since_checkpoint_ >= checkpoint_interval_;
+  }
+
+  // Replaces the log with a single checkpoint record: the application state
+  // followed by history, the serialized undo and redo stacks. No command may
+  // run meanwhile, or the state would not match the history and the records
+  // appended so far.
+  void checkpoint(std::string_view history) {
+    StateSaver saver;
+    {
+      std::lock_guard lock(mutex_);
+      saver = state_saver_;
+    }
+    if (!saver) return;
+    BinaryWriter state;
+    saver(state);
+    BinaryWriter out;
+    out.writeBytes(state.data());
+    std::string payload = out.data();
+    payload.append(history);
+
+    std::string contents;
+    appendRecord(contents, RecordKind::CHECKPOINT, payload);
+
+    std::lock_guard io_lock(io_mutex_);
+    uint64_t covered = 0;
+    {
+      // Records the flusher has not written yet are covered by the checkpoint.
+      std::lock_guard lock(mutex_);
+      pending_.clear();
+      ++generation_;
+      covered = last_sequence_;
+      records_since_checkpoint_ = 0;
+    }
+    auto tmp = path_;
+    tmp += ".tmp";
+    writeFile(tmp, contents);
+    std::fclose(file_);
+    std::filesystem::rename(tmp, path_);
+    openForAppend();
+    markDurable(covered);
+  }
+
+  // Returns the last checkpoint (if any) followed by the records written after
+  // it. A torn or corrupt tail is cut off so new records stay reachable.
+  std::vector<Record> readRecords() {
+    std::lock_guard io_lock(io_mutex_);
+    std::string contents;
+    if (std::FILE* in = std::fopen(path_.string().c_str(), "rb")) {
+      char chunk[1 << 16];
+      size_t n = 0;
+      while ((n = std::fread(chunk, 1, sizeof(chunk), in)) > 0) {
+        contents.append(chunk, n);
+      }
+      std::fclose(in);
+    }
+
+    std::vector<Record> records;
+    if (!contents.starts_with(kMagic)) {
+      // Crashed before the header was written, start over.
+      std::fclose(file_);
+      writeFile(path_, {});
+      openForAppend();
+      return records;
+    }
+
+    size_t offset = kMagic.size();
+    while (contents.size() - offset >= kHeaderSize) {
+      uint32_t size = 0;
+      uint32_t checksum = 0;
+      std::memcpy(&size, contents.data() + offset, sizeof(size));
+      std::memcpy(&checksum, contents.data() + offset + 4, sizeof(checksum));
+      if (size > contents.size() - offset - kHeaderSize) break;
+      const std::string_view body(contents.data() + offset + 8, size + 1);
+      if (fnv1a(body) != checksum) break;
+
+      const auto kind = static_cast<RecordKind>(body[0]);
+      if (kind == RecordKind::CHECKPOINT) records.clear();
+      records.push_back({kind, std::string(body.substr(1))});
+      offset += kHeaderSize + size;
+    }
+
+    if (offset < contents.size()) {
+      std::fclose(file_);
+      std::filesystem::resize_file(path_, offset);
+      openForAppend();
+    }
+    return records;
+  }
+
+  void loadState(BinaryReader& in) const {
+    if (state_loader_) state_loader_(in);
+  }
+
+ private:
+  static constexpr std::string_view kMagic = "CJNL";
+  static constexpr size_t kHeaderSize = 2 * sizeof(uint32_t) + 1;
+  static constexpr size_t kGroupCommitBytes = 64 * 1024;
+
+  static uint32_t fnv1a(std::string_view bytes) {
+    uint32_t hash = 2166136261u;
+    for (char c : bytes) {
+      hash = (hash ^ static_cast<uint8_t>(c)) * 16777619u;
+    }
+    return hash;
+  }
+
+  static void appendRecord(std::string& out, RecordKind kind,
+                           std::string_view payload) {
+    std::string body(1, static_cast<char>(kind));
+    body.append(payload);
+    const auto size = static_cast<uint32_t>(payload.size());
+    const auto checksum = fnv1a(body);
+    out.append(reinterpret_cast<const char*>(&size), sizeof(size));
+    out.append(reinterpret_cast<const char*>(&checksum), sizeof(checksum));
+    out.append(body);
+  }
+
+  static void syncToDisk(std::FILE* file) {
+    std::fflush(file);
+#ifdef _WIN32
+    _commit(_fileno(file));
+#else
+    fsync(fileno(file));
+#endif
+  }
+
+  static void writeFile(const std::filesystem::path& path,
+                        std::string_view records) {
+    std::FILE* out = std::fopen(path.string().c_str(), "wb");
+    if (!out) {
+      throw std::filesystem::filesystem_error(
+          "cannot create journal", path,
+          std::make_error_code(std::errc::io_error));
+    }
+    std::fwrite(kMagic.data(), 1, kMagic.size(), out);
+    if (!records.empty()) {
+      std::fwrite(records.data(), 1, records.size(), out);
+    }
+    syncToDisk(out);
+    std::fclose(out);
+  }
+
+  void openForAppend() {
+    file_ = std::fopen(path_.string().c_str(), "ab");
+    if (!file_) {
+      throw std::filesystem::filesystem_error(
+          "cannot open journal", path_,
+          std::make_error_code(std::errc::io_error));
+    }
+  }
+
+  void markDurable(uint64_t sequence) {
+    {
+      std::lock_guard lock(mutex_);
+      durable_sequence_ = std::max(durable_sequence_, sequence);
+    }
+    durable_.notify_all();
+  }
+
+  void flushLoop(std::stop_token st) {
+    while (true) {
+      std::string batch;
+      uint64_t sequence = 0;
+      uint64_t generation = 0;
+      {
+        std::unique_lock lock(mutex_);
+        // Give concurrent appends a chance to join the batch before paying
+        // for the fsync, unless the batch is already large or a sync waits.
+        condition_.wait(lock, st, [this] { return !pending_.empty(); });
+        condition_.wait_for(lock, st, group_commit_window_, [this] {
+          return flush_requested_ || pending_.size() >= kGroupCommitBytes;
+        });
+        if (pending_.empty() && st.stop_requested()) return;
+        batch.swap(pending_);
+        sequence = last_sequence_;
+        generation = generation_;
+        flush_requested_ = false;
+      }
+
+      std::lock_guard io_lock(io_mutex_);
+      {
+        // A checkpoint taken since the swap already covers this batch.
+        std::lock_guard lock(mutex_);
+        if (generation != generation_) continue;
+      }
+      std::fwrite(batch.data(), 1, batch.size(), file_);
+      syncToDisk(file_);
+      markDurable(sequence);
+    }
+  }
+
+  std::filesystem::path path_;
+  std::chrono::milliseconds group_commit_window_;
+  CommandRegistry registry_;
+  StateSaver state_saver_;
+  StateLoader state_loader_;
+  size_t checkpoint_interval_ = 0;
+  size_t records_since_checkpoint_ = 0;
+
+  mutable std::mutex mutex_;  // guards the fields below and the handlers
+  std::condition_variable_any condition_;
+  std::condition_variable_any durable_;
+  std::string pending_;
+  uint64_t last_sequence_ = 0;
+  uint64_t durable_sequence_ = 0;
+  uint64_t generation_ = 0;  // bumped by every checkpoint
+  bool flush_requested_ = false;
+
+  std::mutex io_mutex_;  // serializes file access of the flusher and checkpoint
+  std::FILE* file_ = nullptr;
+  std::jthread flusher_;
 };
 
 class CommandManager {
  public:
-  constexpr explicit CommandManager(size_t max_undo_levels = 100)
-      : max_undo_levels_(max_undo_levels) {}
+  explicit CommandManager(
+      size_t max_undo_levels = 100,
+      size_t max_history_bytes = std::numeric_limits<size_t>::max())
+      : max_undo_levels_(max_undo_levels),
+        max_history_bytes_(max_history_bytes) {}
+
+  ~CommandManager() {
+    cancelPendingCommands();
+    executor_.reset();
+  }
 
+  CommandManager(const CommandManager&) = delete;
+  CommandManager& operator=(const CommandManager&) = delete;
+
+  // Waits for pending asynchronous commands first, like undo() and redo(),
+  // so it never runs next to one of them on the same target and lands in the
+  // history after them.
   template <Commandlike T>
   CommandResult<void> executeCommand(std::shared_ptr<T> cmd) {
     if (!cmd->canExecute()) {
@@ -303,59 +1614,150 @@ class CommandManager {
       return CommandResult<void>{};
     }
 
-    auto result = cmd->execute();
-    if (!result.has_value()) {
-      return result;
-    }
+    waitForAsyncCommands();
+    return executeAndRecord(std::move(cmd));
+  }
 
-    for (const auto& observer : observers_) {
-      observer->onCommandExecuted(*cmd);
-    }
+  // Runs the command on a background executor and records it in the history
+  // once it finishes. Commands with the same target run one at a time, in the
+  // order they were submitted, and commands without a target run alone.
+  // Pending and running commands can be abandoned with
+  // cancelPendingCommands() or cmd->cancel().
+  template <Commandlike T>
+  std::future<CommandResult<void>> executeCommandAsync(std::shared_ptr<T> cmd) {
+    auto promise = std::make_shared<std::promise<CommandResult<void>>>();
+    auto future = promise->get_future();
 
-    if (cmd->canUndo()) {
-      undo_stack_.push_back(std::move(cmd));
-      redo_stack_.clear();
+    if (!cmd->canExecute() || current_group_) {
+      promise->set_value(executeCommand(std::move(cmd)));
+      return future;
+    }
 
-      while (undo_stack_.size() > max_undo_levels_) {
-        undo_stack_.erase(undo_stack_.begin());
+    std::stop_token token;
+    CommandExecutor* executor = nullptr;
+    {
+      std::lock_guard lock(history_mutex_);
+      if (!executor_) {
+        executor_ = std::make_unique<CommandExecutor>();
       }
+      executor = executor_.get();
+      token = stop_source_.get_token();
     }
-    return result;
+
+    const void* target = cmd->getTarget();
+    executor->submit(target, [this, cmd = std::shared_ptr<Command>(
+                                        std::move(cmd)),
+                              promise, token] {
+      try {
+        if (token.stop_requested()) {
+          promise->set_value(std::unexpected(CommandError::CANCELLED));
+          return;
+        }
+        promise->set_value(executeAndRecord(cmd, token));
+      } catch (...) {
+        promise->set_exception(std::current_exception());
+      }
+    });
+    return future;
   }
 
-  void undo() {
-    if (undo_stack_.empty()) return;
+  // Requests cancellation of every asynchronous command submitted so far.
+  // Commands submitted afterwards are not affected.
+  void cancelPendingCommands() {
+    std::lock_guard lock(history_mutex_);
+    stop_source_.request_stop();
+    stop_source_ = std::stop_source{};
+  }
 
-    auto& cmd = undo_stack_.back();
-    cmd->undo();
-    for (const auto& observer : observers_) {
-      observer->onCommandUndone(*cmd);
+  // Undo and redo first wait for pending asynchronous commands, so they act
+  // on the history those commands leave behind. The command runs outside the
+  // history lock and is only moved to the other stack if it succeeds.
+  CommandResult<void> undo() {
+    waitForAsyncCommands();
+    std::shared_ptr<Command> cmd;
+    {
+      std::lock_guard lock(history_mutex_);
+      if (undo_stack_.empty()) return {};
+      cmd = popEntry(undo_stack_).command;
     }
 
-    redo_stack_.push_back(std::move(cmd));
-    undo_stack_.pop_back();
+    if (auto result = cmd->undo(); !result) {
+      std::lock_guard lock(history_mutex_);
+      pushEntry(undo_stack_, std::move(cmd));
+      return result;
+    }
+    {
+      std::lock_guard lock(history_mutex_);
+      pushEntry(redo_stack_, cmd);
+      journal(CommandJournal::RecordKind::UNDONE, *cmd);
+    }
+    scheduleCheckpoint();
+    notify(CommandEvent::Kind::UNDONE, std::move(cmd));
+    return {};
   }
 
-  void redo() {
-    if (redo_stack_.empty()) return;
-
-    auto& cmd = redo_stack_.back();
-    cmd->execute();
-    for (const auto& observer : observers_) {
-      observer->onCommandRedone(*cmd);
+  CommandResult<void> redo() {
+    waitForAsyncCommands();
+    std::shared_ptr<Command> cmd;
+    {
+      std::lock_guard lock(history_mutex_);
+      if (redo_stack_.empty()) return {};
+      cmd = popEntry(redo_stack_).command;
     }
 
-    undo_stack_.push_back(std::move(cmd));
-    redo_stack_.pop_back();
+    if (auto result = cmd->execute(); !result) {
+      std::lock_guard lock(history_mutex_);
+      pushEntry(redo_stack_, std::move(cmd));
+      return result;
+    }
+    {
+      std::lock_guard lock(history_mutex_);
+      pushEntry(undo_stack_, cmd);
+      evictHistory();
+      journal(CommandJournal::RecordKind::REDONE, *cmd);
+    }
+    scheduleCheckpoint();
+    notify(CommandEvent::Kind::REDONE, std::move(cmd));
+    return {};
   }
 
-  [[nodiscard]] constexpr bool canUndo() const { return !undo_stack_.empty(); }
-  [[nodiscard]] constexpr bool canRedo() const { return !redo_stack_.empty(); }
-  [[nodiscard]] constexpr std::string_view getUndoName() const noexcept {
-    return canUndo() ? undo_stack_.back()->getName() : "Nothing to undo";
+  [[nodiscard]] bool canUndo() const {
+    std::lock_guard lock(history_mutex_);
+    return !undo_stack_.empty();
   }
-  [[nodiscard]] constexpr std::string_view getRedoName() const noexcept {
-    return canRedo() ? redo_stack_.back()->getName() : "Nothing to redo";
+  [[nodiscard]] bool canRedo() const {
+    std::lock_guard lock(history_mutex_);
+    return !redo_stack_.empty();
+  }
+  [[nodiscard]] std::string getUndoName() const {
+    std::lock_guard lock(history_mutex_);
+    return undo_stack_.empty()
+               ? "Nothing to undo"
+               : std::string(undo_stack_.back().command->getName());
+  }
+  [[nodiscard]] std::string getRedoName() const {
+    std::lock_guard lock(history_mutex_);
+    return redo_stack_.empty()
+               ? "Nothing to redo"
+               : std::string(redo_stack_.back().command->getName());
+  }
+  // Bytes held by the undo and redo stacks, as reported by the commands,
+  // plus the shared memory they keep alive.
+  [[nodiscard]] size_t getHistoryBytes() const {
+    std::lock_guard lock(history_mutex_);
+    return history_bytes_ + sharedBytes();
+  }
+  // Counts memory that commands share, such as the keyframes of a
+  // SnapshotStore, against the byte budget. It is not part of any one
+  // command's footprint, but it is freed as their history is evicted.
+  void addSharedMemory(std::function<size_t()> bytes) {
+    std::lock_guard lock(history_mutex_);
+    shared_memory_.push_back(std::move(bytes));
+    evictHistory();
+  }
+  [[nodiscard]] size_t getUndoLevels() const {
+    std::lock_guard lock(history_mutex_);
+    return undo_stack_.size();
   }
 
   void beginCommandGroup(std::string_view name) {
@@ -369,16 +1771,304 @@ class CommandManager {
     }
   }
 
+  // Observers may be called from executor threads, but never concurrently:
+  // one notification is delivered to every observer before the next one.
   void addObserver(std::shared_ptr<CommandObserver> observer) {
-    observers_.push_back(observer);
+    std::lock_guard lock(observers_mutex_);
+    if (dispatcher_) {
+      dispatcher_->addObserver(observer);
+    }
+    observers_.push_back(std::move(observer));
+  }
+
+  // From now on observers are notified in batches on a background thread
+  // instead of synchronously by the thread that ran the command. Observers
+  // then see a snapshot of the command as it was when it finished.
+  void enableBatchedNotifications(size_t ring_capacity = 1024) {
+    std::lock_guard lock(observers_mutex_);
+    if (!dispatcher_) {
+      dispatcher_ =
+          std::make_unique<NotificationDispatcher>(observers_, ring_capacity);
+    }
+  }
+
+  // Blocks until every batched notification so far has been delivered.
+  void flushNotifications() {
+    if (auto* dispatcher = getDispatcher()) dispatcher->flush();
+  }
+
+  // Records every serializable command that is executed, undone or redone.
+  // Commands that are not serializable are neither journaled nor recovered.
+  void setJournal(std::shared_ptr<CommandJournal> journal) {
+    std::lock_guard lock(history_mutex_);
+    journal_ = std::move(journal);
+  }
+
+  // Rebuilds the application state and the history from the journal: the
+  // last checkpoint is loaded and the records after it are replayed. Meant to
+  // be called on startup, before any new command is executed.
+  CommandResult<void> recoverFromJournal() {
+    if (!journal_) return std::unexpected(CommandError::INVALID_STATE);
+
+    replaying_ = true;
+    CommandResult<void> result;
+    for (const auto& record : journal_->readRecords()) {
+      BinaryReader in(record.payload);
+      switch (record.kind) {
+        case CommandJournal::RecordKind::CHECKPOINT: {
+          BinaryReader state(in.readBytes());
+          journal_->loadState(state);
+          std::lock_guard lock(history_mutex_);
+          undo_stack_.clear();
+          redo_stack_.clear();
+          history_bytes_ = 0;
+          if (!readStack(in, undo_stack_) || !readStack(in, redo_stack_)) {
+            result = std::unexpected(CommandError::EXECUTION_FAILED);
+          }
+          break;
+        }
+        case CommandJournal::RecordKind::EXECUTED:
+          if (auto cmd = journal_->registry().readCommand(in)) {
+            result = executeAndRecord(std::move(cmd));
+          } else {
+            result = std::unexpected(CommandError::EXECUTION_FAILED);
+          }
+          break;
+        case CommandJournal::RecordKind::UNDONE:
+          result = undo();
+          break;
+        case CommandJournal::RecordKind::REDONE:
+          result = redo();
+          break;
+      }
+      if (!result) break;
+    }
+    replaying_ = false;
+    return result;
   }
 
  private:
-  std::vector<std::shared_ptr<Command>> undo_stack_;
-  std::vector<std::shared_ptr<Command>> redo_stack_;
+  struct HistoryEntry {
+    std::shared_ptr<Command> command;
+    size_t bytes;  // footprint at the time the entry was pushed
+  };
+
+  // The stop token only applies to this run. It is cleared afterwards, so a
+  // later cancelPendingCommands() cannot cancel a redo of the command.
+  CommandResult<void> executeAndRecord(std::shared_ptr<Command> cmd,
+                                       std::stop_token token = {}) {
+    cmd->setStopToken(std::move(token));
+    auto result = cmd->execute();
+    cmd->setStopToken({});
+    if (!result.has_value()) {
+      return result;
+    }
+
+    notify(CommandEvent::Kind::EXECUTED, cmd);
+
+    {
+      std::lock_guard lock(history_mutex_);
+      if (cmd->canUndo()) {
+        for (const auto& entry : redo_stack_) {
+          history_bytes_ -= entry.bytes;
+        }
+        redo_stack_.clear();
+        pushEntry(undo_stack_, cmd);
+        evictHistory();
+      }
+      journal(CommandJournal::RecordKind::EXECUTED, *cmd);
+    }
+    scheduleCheckpoint();
+    return result;
+  }
+
+  void waitForAsyncCommands() {
+    CommandExecutor* executor = nullptr;
+    {
+      std::lock_guard lock(history_mutex_);
+      executor = executor_.get();
+    }
+    if (executor) executor->waitIdle();
+  }
+
+  // A checkpoint copies the application state, which commands change without
+  // holding history_mutex_, so it must not overlap any of them. It runs as an
+  // exclusive executor task, after the commands before it and before the
+  // ones after it, or right away on the calling thread if nothing runs
+  // asynchronously. Expects history_mutex_ not to be held.
+  void scheduleCheckpoint() {
+    CommandExecutor* executor = nullptr;
+    {
+      std::lock_guard lock(history_mutex_);
+      if (!journal_ || replaying_ || checkpoint_scheduled_ ||
+          !journal_->checkpointDue()) {
+        return;
+      }
+      checkpoint_scheduled_ = true;
+      executor = executor_.get();
+    }
+    if (!executor) {
+      checkpoint();
+      return;
+    }
+    executor->submit(nullptr, [this] {
+      try {
+        checkpoint();
+      } catch (const std::filesystem::filesystem_error&) {
+        // Not fatal here: the next record schedules another attempt.
+      }
+    });
+  }
+
+  void checkpoint() {
+    BinaryWriter history;
+    std::shared_ptr<CommandJournal> journal;
+    {
+      std::lock_guard lock(history_mutex_);
+      checkpoint_scheduled_ = false;
+      // Checkpoints need the whole history, wait until it is serializable.
+      const auto serializable = [](const HistoryEntry& entry) {
+        return entry.command->getTypeId() != 0;
+      };
+      if (!journal_ || !std::ranges::all_of(undo_stack_, serializable) ||
+          !std::ranges::all_of(redo_stack_, serializable)) {
+        return;
+      }
+      writeStack(history, undo_stack_);
+      writeStack(history, redo_stack_);
+      journal = journal_;
+    }
+    // Saving the state and replacing the file do not need the history.
+    journal->checkpoint(history.data());
+  }
+
+  // The dispatcher is created once and lives as long as the manager, so the
+  // pointer stays valid after the lock is released.
+  NotificationDispatcher* getDispatcher() {
+    std::lock_guard lock(observers_mutex_);
+    return dispatcher_.get();
+  }
+
+  void notify(CommandEvent::Kind kind, std::shared_ptr<const Command> cmd) {
+    NotificationDispatcher* dispatcher = nullptr;
+    std::vector<std::shared_ptr<CommandObserver>> observers;
+    {
+      std::lock_guard lock(observers_mutex_);
+      dispatcher = dispatcher_.get();
+      if (!dispatcher) observers = observers_;
+    }
+    if (dispatcher) {
+      dispatcher->publish({kind, std::make_shared<CommandSnapshot>(*cmd)});
+      return;
+    }
+    // Recursive, so a callback that runs a command synchronously is not
+    // blocked by its own delivery.
+    std::lock_guard delivery(delivery_mutex_);
+    for (const auto& observer : observers) {
+      switch (kind) {
+        case CommandEvent::Kind::EXECUTED:
+          observer->onCommandExecuted(*cmd);
+          break;
+        case CommandEvent::Kind::UNDONE:
+          observer->onCommandUndone(*cmd);
+          break;
+        case CommandEvent::Kind::REDONE:
+          observer->onCommandRedone(*cmd);
+          break;
+      }
+    }
+  }
+
+  // The helpers below expect history_mutex_ to be held.
+
+  void journal(CommandJournal::RecordKind kind, const Command& cmd) {
+    if (!journal_ || replaying_ || cmd.getTypeId() == 0) return;
+
+    BinaryWriter payload;
+    if (kind == CommandJournal::RecordKind::EXECUTED) {
+      writeCommand(payload, cmd);
+    }
+    journal_->append(kind, payload.data());
+  }
+
+  static void writeStack(BinaryWriter& out,
+                         const std::vector<HistoryEntry>& stack) {
+    out.writeVarint(stack.size());
+    for (const auto& entry : stack) {
+      writeCommand(out, *entry.command);
+    }
+  }
+
+  bool readStack(BinaryReader& in, std::vector<HistoryEntry>& stack) {
+    const auto count = in.readVarint();
+    for (uint64_t i = 0; i < count && in.ok(); ++i) {
+      auto cmd = journal_->registry().readCommand(in);
+      if (!cmd) return false;
+      pushEntry(stack, std::move(cmd));
+    }
+    return in.ok();
+  }
+
+  void pushEntry(std::vector<HistoryEntry>& stack,
+                 std::shared_ptr<Command> cmd) {
+    // Footprints may change between execute and undo (e.g. captured state),
+    // so they are re-measured every time a command moves between stacks.
+    const size_t bytes = cmd->getMemoryFootprint();
+    history_bytes_ += bytes;
+    stack.push_back({std::move(cmd), bytes});
+  }
+
+  HistoryEntry popEntry(std::vector<HistoryEntry>& stack) {
+    auto entry = std::move(stack.back());
+    stack.pop_back();
+    history_bytes_ -= entry.bytes;
+    return entry;
+  }
+
+  [[nodiscard]] size_t sharedBytes() const {
+    size_t bytes = 0;
+    for (const auto& measure : shared_memory_) bytes += measure();
+    return bytes;
+  }
+
+  // Drops the oldest undo entries until both the level and the byte budget
+  // are satisfied. The most recent command is always kept so it can be undone
+  // even if it alone exceeds the budget. Each command is released before the
+  // budget is checked again, so the shared memory it kept alive is freed.
+  void evictHistory() {
+    size_t evicted = 0;
+    while (undo_stack_.size() - evicted > 1 &&
+           (undo_stack_.size() - evicted > max_undo_levels_ ||
+            history_bytes_ + sharedBytes() > max_history_bytes_)) {
+      history_bytes_ -= undo_stack_[evicted].bytes;
+      undo_stack_[evicted].command.reset();
+      ++evicted;
+    }
+    if (evicted > 0) {
+      undo_stack_.erase(undo_stack_.begin(),
+                        undo_stack_.begin() + static_cast<std::ptrdiff_t>(
+                                                  evicted));
+    }
+  }
+
+  std::vector<HistoryEntry> undo_stack_;
+  std::vector<HistoryEntry> redo_stack_;
   const size_t max_undo_levels_;
+  const size_t max_history_bytes_;
+  size_t history_bytes_ = 0;
+  std::vector<std::function<size_t()>> shared_memory_;
   std::shared_ptr<BulkCommand> current_group_;
   std::vector<std::shared_ptr<CommandObserver>> observers_;
+  std::mutex observers_mutex_;  // guards observers_ and dispatcher_
+  std::recursive_mutex delivery_mutex_;  // serializes observer callbacks
+  mutable std::mutex history_mutex_;
+  std::stop_source stop_source_;
+  std::shared_ptr<CommandJournal> journal_;
+  bool replaying_ = false;
+  bool checkpoint_scheduled_ = false;
+  std::unique_ptr<NotificationDispatcher> dispatcher_;
+  // Declared last so its workers are joined before the history goes away.
+  std::unique_ptr<CommandExecutor> executor_;
 };
 
 class CommandGroup {
@@ -440,14 +2130,174 @@ int main() {
                  commandErrorToString(result.error()));
   }
 
+  // Independent edits in one group run in parallel waves
+  {
+    std::vector<float> angles(100'000, 0.0f);
+    const auto start = std::chrono::steady_clock::now();
+    {
+      CommandGroup group(manager, "Rotate All");
+      for (auto& a : angles) {
+        manager.executeCommand(std::make_shared<RotationCommand>(a, 90.0f));
+      }
+    }
+    std::println("Rotated {} angles in one group in {}ms", angles.size(),
+                 std::chrono::duration_cast<std::chrono::milliseconds>(
+                     std::chrono::steady_clock::now() - start)
+                     .count());
+  }
+
   // Slow command
   bool toggle = false;
   manager.executeCommand(std::make_shared<ToggleCommand>(toggle));
 
+  // Slow commands off the calling thread. Toggles of the same flag are
+  // serialized, so the second one starts only after the first has finished.
+  {
+    auto first = manager.executeCommandAsync(
+        std::make_shared<ToggleCommand>(toggle, "Async Toggle 1"));
+    auto second = manager.executeCommandAsync(
+        std::make_shared<ToggleCommand>(toggle, "Async Toggle 2"));
+    std::println("Async toggle 1 succeeded: {}", first.get().has_value());
+
+    // Abandon the second toggle while it is still running.
+    std::this_thread::sleep_for(100ms);
+    manager.cancelPendingCommands();
+    if (auto cancelled = second.get(); !cancelled.has_value()) {
+      std::println("Async toggle 2: {}",
+                   commandErrorToString(cancelled.error()));
+    }
+  }
+
   // UI integration
   if (manager.canUndo()) {
     std::println("Undo available: {}", manager.getUndoName());
   }
 
+  // Memory-budgeted history of a large document
+  {
+    // The budget covers the store's uncompressed copy of the document too.
+    constexpr size_t kHistoryBudget = 1088 * 1024;
+    SnapshotStore store;
+    CommandManager document_manager(1000, kHistoryBudget);
+    document_manager.addSharedMemory(
+        [&store] { return store.getMemoryFootprint(); });
+    std::string document(1024 * 1024, ' ');
+
+    for (size_t i = 0; i < 200; ++i) {
+      document_manager.executeCommand(std::make_shared<EditDocumentCommand>(
+          document, store, [i](std::string& doc) {
+            doc.replace(i * 4096, 11, "edit #" + std::to_string(i));
+          }));
+    }
+    std::println("Document history: {} undo levels in {} KiB (budget {} KiB)",
+                 document_manager.getUndoLevels(),
+                 document_manager.getHistoryBytes() / 1024,
+                 kHistoryBudget / 1024);
+
+    while (document_manager.canUndo()) {
+      document_manager.undo();
+    }
+    std::println("Document after undoing all retained edits starts with: '{}'",
+                 document.substr(0, 24));
+  }
+
+  // Batched notifications: slow observers no longer slow down commands
+  {
+    class SlowObserver : public CommandObserver {
+     public:
+      void onCommandExecuted(const Command&) override { work(); }
+      void onCommandUndone(const Command&) override { work(); }
+      void onCommandRedone(const Command&) override { work(); }
+
+     private:
+      static void work() { std::this_thread::sleep_for(100us); }
+    };
+
+    const auto run = [](bool batched) {
+      CommandManager observed;
+      for (int i = 0; i < 8; ++i) {
+        observed.addObserver(std::make_shared<SlowObserver>());
+      }
+      if (batched) observed.enableBatchedNotifications();
+
+      float value = 0.0f;
+      const auto start = std::chrono::steady_clock::now();
+      for (int i = 0; i < 500; ++i) {
+        observed.executeCommand(
+            std::make_shared<RotationCommand>(value, static_cast<float>(i)));
+      }
+      const auto elapsed = std::chrono::steady_clock::now() - start;
+      observed.flushNotifications();
+      return std::chrono::duration_cast<std::chrono::microseconds>(elapsed);
+    };
+    std::println("500 commands with 8 slow observers: {}us synchronous, {}us "
+                 "batched",
+                 run(false).count(), run(true).count());
+  }
+
+  // Crash recovery from the command journal
+  {
+    const auto path =
+        std::filesystem::temp_directory_path() / "undo-framework.journal";
+    std::filesystem::remove(path);
+
+    struct Scene {
+      int x = 0;
+      int y = 0;
+      float angle = 0.0f;
+    };
+    const auto open_journal = [&path](Scene& scene) {
+      auto journal = std::make_shared<CommandJournal>(path);
+      auto& registry = journal->registry();
+      registry.registerType<MoveCommand>(
+          [&scene](BinaryReader& in, std::string_view name) {
+            return MoveCommand::deserialize(in, scene.x, scene.y, name);
+          });
+      registry.registerType<RotationCommand>(
+          [&scene](BinaryReader& in, std::string_view name) {
+            return RotationCommand::deserialize(in, scene.angle, name);
+          });
+      journal->setStateHandlers(
+          [&scene](BinaryWriter& out) { out.write(scene); },
+          [&scene](BinaryReader& in) { scene = in.read<Scene>(); },
+          4);
+      return journal;
+    };
+
+    Scene before_crash;
+    {
+      CommandManager session;
+      auto journal = open_journal(before_crash);
+      session.setJournal(journal);
+      for (int i = 1; i <= 5; ++i) {
+        session.executeCommand(std::make_shared<MoveCommand>(
+            before_crash.x, before_crash.y, i, i * 2));
+      }
+      {
+        CommandGroup group(session, "Move and Rotate");
+        session.executeCommand(std::make_shared<MoveCommand>(
+            before_crash.x, before_crash.y, 100, 200));
+        session.executeCommand(
+            std::make_shared<RotationCommand>(before_crash.angle, 90.0f));
+      }
+      session.undo();
+      journal->sync();
+    }
+
+    Scene recovered;
+    CommandManager session;
+    session.setJournal(open_journal(recovered));
+    if (session.recoverFromJournal()) {
+      std::println("Recovered ({}, {}) angle {}, expected ({}, {}) angle {}",
+                   recovered.x, recovered.y, recovered.angle, before_crash.x,
+                   before_crash.y, before_crash.angle);
+      std::println("Recovered redo: {}", session.getRedoName());
+      session.redo();
+      std::println("After redo: ({}, {}) angle {}", recovered.x, recovered.y,
+                   recovered.angle);
+    }
+    std::filesystem::remove(path);
+  }
+
   return 0;
 }
@@ -0,0 +1,417 @@
+#pragma once
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(_MSC_VER) && !defined(__clang__)
+#include <xmmintrin.h>
+#endif
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <ranges>
+#include <span>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Binary searches that return positions instead of a bool. lower_bound is
+// the first position whose element is not less than the value, upper_bound
+// the first whose element is greater, and equal_range the pair of both; all
+// of them return arr.size() when there is no such element.
+//
+// Three implementations share that interface:
+// - lower_bound: the textbook loop. Every step branches on the comparison,
+//   which mispredicts half the time on random queries, and the next probe
+//   address is only known once the current element has arrived from memory.
+// - branchless_lower_bound: the comparison picks the next half with a
+//   conditional move, so there is nothing to mispredict. Both candidate
+//   midpoints of the next step are prefetched before the comparison, which
+//   overlaps the two memory accesses instead of serializing them.
+// - EytzingerSearch: the array is rearranged in breadth-first order, so the
+//   hot top levels share a few cache lines and the descendants
+//   log2(64 / sizeof(T)) levels down, four for 4-byte elements, sit in one
+//   line that can be prefetched well ahead of time.
+template <typename T>
+concept Comparable = std::totally_ordered<T>;
+
+namespace binary_search_detail {
+
+// Prefetching an address that is never read is harmless, so callers do not
+// need to bounds-check it.
+template <typename T>
+void prefetch(const T* address) {
+#if defined(__GNUC__) || defined(__clang__)
+  __builtin_prefetch(address);
+#elif defined(_MSC_VER)
+  _mm_prefetch(reinterpret_cast<const char*>(address), _MM_HINT_T0);
+#endif
+}
+
+// Number of leading elements for which goes_before holds; goes_before must
+// be true for a prefix of arr and false for the rest.
+template <typename T, typename Predicate>
+constexpr size_t partitionPoint(std::span<const T> arr,
+                                Predicate goes_before) {
+  size_t first = 0;
+  size_t count = arr.size();
+  while (count > 0) {
+    const size_t half = count / 2;
+    if (goes_before(arr[first + half])) {
+      first += half + 1;
+      count -= half + 1;
+    } else {
+      count = half;
+    }
+  }
+  return first;
+}
+
+template <typename T, typename Predicate>
+size_t branchlessPartitionPoint(std::span<const T> arr,
+                                Predicate goes_before) {
+  if (arr.empty()) return 0;
+  const T* base = arr.data();
+  size_t count = arr.size();
+  // The answer is always in [base, base + count]. The loop runs exactly
+  // floor(log2(n)) + 1 times for every query.
+  while (count > 1) {
+    const size_t half = count / 2;
+    count -= half;
+    prefetch(base + count / 2);
+    prefetch(base + half + count / 2);
+    base += static_cast<size_t>(goes_before(base[half - 1])) * half;
+  }
+  return static_cast<size_t>(base - arr.data()) +
+         static_cast<size_t>(goes_before(*base));
+}
+
+}  // namespace binary_search_detail
+
+// The value converts to the element type, so lower_bound(arr, 5) works for
+// an array of int64_t too.
+template <Comparable T>
+constexpr size_t lower_bound(std::span<const T> arr,
+                             const std::type_identity_t<T>& value) {
+  return binary_search_detail::partitionPoint(
+      arr, [&value](const T& element) { return element < value; });
+}
+
+template <Comparable T>
+constexpr size_t upper_bound(std::span<const T> arr,
+                             const std::type_identity_t<T>& value) {
+  return binary_search_detail::partitionPoint(
+      arr, [&value](const T& element) { return !(value < element); });
+}
+
+template <Comparable T>
+constexpr std::pair<size_t, size_t> equal_range(
+    std::span<const T> arr, const std::type_identity_t<T>& value) {
+  // Everything before lower is also before upper, so the second search only
+  // has to look at the rest.
+  const size_t lower = lower_bound(arr, value);
+  return {lower, lower + upper_bound(arr.subspan(lower), value)};
+}
+
+template <Comparable T>
+size_t branchless_lower_bound(std::span<const T> arr,
+                              const std::type_identity_t<T>& value) {
+  return binary_search_detail::branchlessPartitionPoint(
+      arr, [&value](const T& element) { return element < value; });
+}
+
+template <Comparable T>
+size_t branchless_upper_bound(std::span<const T> arr,
+                              const std::type_identity_t<T>& value) {
+  return binary_search_detail::branchlessPartitionPoint(
+      arr, [&value](const T& element) { return !(value < element); });
+}
+
+template <Comparable T>
+std::pair<size_t, size_t> branchless_equal_range(
+    std::span<const T> arr, const std::type_identity_t<T>& value) {
+  const size_t lower = branchless_lower_bound(arr, value);
+  return {lower, lower + branchless_upper_bound(arr.subspan(lower), value)};
+}
+
+template <typename Range>
+concept SearchableRange = std::ranges::contiguous_range<Range> &&
+                          Comparable<std::ranges::range_value_t<Range>>;
+
+template <SearchableRange Range>
+using ElementSpan = std::span<const std::ranges::range_value_t<Range>>;
+
+template <SearchableRange Range>
+constexpr size_t lower_bound(Range&& range,
+                             const std::ranges::range_value_t<Range>& value) {
+  return lower_bound(ElementSpan<Range>(range), value);
+}
+
+template <SearchableRange Range>
+constexpr size_t upper_bound(Range&& range,
+                             const std::ranges::range_value_t<Range>& value) {
+  return upper_bound(ElementSpan<Range>(range), value);
+}
+
+template <SearchableRange Range>
+constexpr std::pair<size_t, size_t> equal_range(
+    Range&& range, const std::ranges::range_value_t<Range>& value) {
+  return equal_range(ElementSpan<Range>(range), value);
+}
+
+template <SearchableRange Range>
+size_t branchless_lower_bound(Range&& range,
+                              const std::ranges::range_value_t<Range>& value) {
+  return branchless_lower_bound(ElementSpan<Range>(range), value);
+}
+
+template <SearchableRange Range>
+size_t branchless_upper_bound(Range&& range,
+                              const std::ranges::range_value_t<Range>& value) {
+  return branchless_upper_bound(ElementSpan<Range>(range), value);
+}
+
+template <SearchableRange Range>
+std::pair<size_t, size_t> branchless_equal_range(
+    Range&& range, const std::ranges::range_value_t<Range>& value) {
+  return branchless_equal_range(ElementSpan<Range>(range), value);
+}
+
+// A copy of a sorted array in Eytzinger (breadth-first) order: the children
+// of slot k are slots 2k and 2k + 1. Searches return positions in the
+// original sorted array, which are computed from the final slot rather than
+// stored, so the copy costs no more memory than the array itself.
+template <Comparable T>
+class EytzingerSearch {
+ public:
+  EytzingerSearch() = default;
+
+  // values must be sorted; duplicates are allowed.
+  explicit EytzingerSearch(std::span<const T> values)
+      : data_(values.size() + 1) {
+    if (!std::ranges::is_sorted(values)) {
+      throw std::invalid_argument("EytzingerSearch: values must be sorted");
+    }
+    for (size_t k = 1; k < data_.size(); ++k) data_[k] = values[rankOf(k)];
+  }
+
+  [[nodiscard]] size_t lower_bound(const T& value) const {
+    return search([&value](const T& element) { return element < value; });
+  }
+
+  [[nodiscard]] size_t upper_bound(const T& value) const {
+    return search([&value](const T& element) { return !(value < element); });
+  }
+
+  [[nodiscard]] std::pair<size_t, size_t> equal_range(const T& value) const {
+    return {lower_bound(value), upper_bound(value)};
+  }
+
+  [[nodiscard]] size_t size() const noexcept {
+    return data_.empty() ? 0 : data_.size() - 1;
+  }
+  [[nodiscard]] bool empty() const noexcept { return size() == 0; }
+
+ private:
+  // The walk below is FrozenTree::lower_bound from
+  // src/data-structures/binary-tree/frozen_tree.h, generalized to a
+  // predicate and returning a position. The comments there explain the
+  // prefetch stride and how the final slot is recovered from k.
+  static constexpr size_t kPrefetchStride =
+      std::bit_floor(std::max<size_t>(1, 64 / sizeof(T)));
+
+  template <typename Predicate>
+  size_t search(Predicate goes_before) const {
+    const size_t n = size();
+    size_t k = 1;
+    while (k <= n) {
+      binary_search_detail::prefetch(data_.data() + k * kPrefetchStride);
+      k = 2 * k + static_cast<size_t>(goes_before(data_[k]));
+    }
+    k >>= std::countr_one(k) + 1;
+    return k == 0 ? n : rankOf(k);
+  }
+
+  // In-order position of slot k. In a perfect tree of height h, slot k at
+  // depth d is at 1-based position (2 (k - 2^d) + 1) * 2^(h - 1 - d). The
+  // last level is only filled from the left, so the missing leaves before
+  // that position, which all sit at odd positions, are subtracted.
+  [[nodiscard]] size_t rankOf(size_t k) const {
+    const size_t n = size();
+    const auto height = static_cast<size_t>(std::bit_width(n));
+    const auto depth = static_cast<size_t>(std::bit_width(k)) - 1;
+    const size_t level_start = size_t{1} << depth;
+    const size_t position = (2 * (k - level_start) + 1)
+                            << (height - 1 - depth);
+    const size_t last_leaf = 2 * (n - (size_t{1} << (height - 1))) + 1;
+    const size_t missing =
+        position > last_leaf ? (position - last_leaf - 1) / 2 : 0;
+    return position - 1 - missing;
+  }
+
+  std::vector<T> data_;  // slot 0 unused
+};
+
+// Batched lower_bound: out[i] = lower_bound(sorted, queries[i]).
+//
+// A single search on a large array spends most of its time waiting for one
+// load at a time. Searching many keys at once keeps many loads in flight:
+// groups of queries advance through the same number of steps in lockstep,
+// and each search prefetches its next probe, which is only read after every
+// other search in the group has taken a step. With AVX2, int32 and float keys
+// go through eight lanes at a time, with a gather loading the eight probes.
+namespace binary_search_detail {
+
+// Searches in flight per group. Enough to cover a DRAM round trip with work
+// from the other searches, and few enough that the prefetched lines stay in
+// L1 until they are read.
+inline constexpr size_t kBatchGroupSize = 32;
+
+template <Comparable T>
+void lowerBoundGroup(std::span<const T> sorted, std::span<const T> queries,
+                     std::span<size_t> out) {
+  std::array<const T*, kBatchGroupSize> base;
+  base.fill(sorted.data());
+  size_t count = sorted.size();
+  while (count > 1) {
+    const size_t half = count / 2;
+    count -= half;
+    const size_t next_probe = count > 1 ? count / 2 - 1 : 0;
+    for (size_t g = 0; g < queries.size(); ++g) {
+      base[g] += static_cast<size_t>(base[g][half - 1] < queries[g]) * half;
+      prefetch(base[g] + next_probe);
+    }
+  }
+  for (size_t g = 0; g < queries.size(); ++g) {
+    out[g] = static_cast<size_t>(base[g] - sorted.data()) +
+             static_cast<size_t>(*base[g] < queries[g]);
+  }
+}
+
+template <Comparable T>
+void lowerBoundGroups(std::span<const T> sorted, std::span<const T> queries,
+                      std::span<size_t> out) {
+  for (size_t first = 0; first < queries.size(); first += kBatchGroupSize) {
+    const size_t count = std::min(kBatchGroupSize, queries.size() - first);
+    lowerBoundGroup(sorted, queries.subspan(first, count),
+                    out.subspan(first, count));
+  }
+}
+
+#if defined(__AVX2__)
+template <typename T>
+concept GatherSearchable = std::same_as<T, int32_t> || std::same_as<T, float>;
+
+template <typename T>
+struct GatherLanes;
+
+template <>
+struct GatherLanes<int32_t> {
+  using Vector = __m256i;
+  static Vector load(const int32_t* p) {
+    return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+  }
+  static Vector gather(const int32_t* base, __m256i index) {
+    return _mm256_i32gather_epi32(base, index, 4);
+  }
+  // All ones in the lanes where a < b.
+  static __m256i less(Vector a, Vector b) { return _mm256_cmpgt_epi32(b, a); }
+};
+
+template <>
+struct GatherLanes<float> {
+  using Vector = __m256;
+  static Vector load(const float* p) { return _mm256_loadu_ps(p); }
+  static Vector gather(const float* base, __m256i index) {
+    return _mm256_i32gather_ps(base, index, 4);
+  }
+  static __m256i less(Vector a, Vector b) {
+    return _mm256_castps_si256(_mm256_cmp_ps(a, b, _CMP_LT_OQ));
+  }
+};
+
+// Eight vectors of eight lanes per group. Their gathers are independent, so
+// up to 64 loads are in flight; explicit prefetches of the lanes cost more
+// than they saved when measured.
+inline constexpr size_t kGatherVectors = 8;
+inline constexpr size_t kGatherGroupSize = 8 * kGatherVectors;
+
+// Positions are kept as int32 lanes, so sorted must have fewer than 2^31
+// elements, and queries a multiple of kGatherGroupSize.
+template <GatherSearchable T>
+void lowerBoundGather(std::span<const T> sorted, std::span<const T> queries,
+                      std::span<size_t> out) {
+  using L = GatherLanes<T>;
+  for (size_t first = 0; first < queries.size(); first += kGatherGroupSize) {
+    typename L::Vector query[kGatherVectors];
+    __m256i pos[kGatherVectors];
+    for (size_t v = 0; v < kGatherVectors; ++v) {
+      query[v] = L::load(queries.data() + first + 8 * v);
+      pos[v] = _mm256_setzero_si256();
+    }
+    size_t count = sorted.size();
+    while (count > 1) {
+      const size_t half = count / 2;
+      count -= half;
+      const __m256i step = _mm256_set1_epi32(static_cast<int32_t>(half));
+      const __m256i probe = _mm256_set1_epi32(static_cast<int32_t>(half - 1));
+      for (size_t v = 0; v < kGatherVectors; ++v) {
+        const auto element =
+            L::gather(sorted.data(), _mm256_add_epi32(pos[v], probe));
+        pos[v] = _mm256_add_epi32(
+            pos[v], _mm256_and_si256(L::less(element, query[v]), step));
+      }
+    }
+    // The compare mask is -1 where the last element is still too small.
+    alignas(32) int32_t result[kGatherGroupSize];
+    for (size_t v = 0; v < kGatherVectors; ++v) {
+      const auto element = L::gather(sorted.data(), pos[v]);
+      pos[v] = _mm256_sub_epi32(pos[v], L::less(element, query[v]));
+      _mm256_store_si256(reinterpret_cast<__m256i*>(result + 8 * v), pos[v]);
+    }
+    for (size_t i = 0; i < kGatherGroupSize; ++i) {
+      out[first + i] = static_cast<size_t>(result[i]);
+    }
+  }
+}
+#endif
+
+}  // namespace binary_search_detail
+
+template <Comparable T>
+void lower_bound_batch(std::span<const T> sorted, std::span<const T> queries,
+                       std::span<size_t> out) {
+  using namespace binary_search_detail;
+  if (queries.size() != out.size()) {
+    throw std::invalid_argument("queries and out must have the same size");
+  }
+  if (sorted.empty()) {
+    std::ranges::fill(out, 0);
+    return;
+  }
+  size_t done = 0;
+#if defined(__AVX2__)
+  if constexpr (GatherSearchable<T>) {
+    if (sorted.size() <=
+        static_cast<size_t>(std::numeric_limits<int32_t>::max())) {
+      done = queries.size() - queries.size() % kGatherGroupSize;
+      lowerBoundGather(sorted, queries.first(done), out.first(done));
+    }
+  }
+#endif
+  lowerBoundGroups(sorted, queries.subspan(done), out.subspan(done));
+}
+
+template <SearchableRange Range, SearchableRange Queries>
+  requires std::same_as<std::ranges::range_value_t<Range>,
+                        std::ranges::range_value_t<Queries>>
+void lower_bound_batch(Range&& sorted, Queries&& queries,
+                       std::span<size_t> out) {
+  lower_bound_batch(ElementSpan<Range>(sorted), ElementSpan<Queries>(queries),
+                    out);
+}
@@ -1,18 +1,25 @@
 #include <algorithm>
 #include <array>
 #include <cassert>
-#include <concepts>
+#include <chrono>
 #include <cstddef>
+#include <cstdint>
+#include <cstdlib>
 #include <print>
+#include <random>
 #include <ranges>
+#include <span>
+#include <string>
 #include <utility>
+#include <vector>
 
-template <typename T>
-concept Comparable = std::totally_ordered<T>;
+#include "binary_search.h"
 
-template <std::ranges::random_access_range Range, Comparable T>
-constexpr auto binary_search(Range&& range, const T& value) noexcept {
-  return std::ranges::binary_search(std::forward<Range>(range), value);
+template <std::ranges::contiguous_range Range, Comparable T>
+constexpr bool binary_search(Range&& range, const T& value) {
+  const std::span<const std::ranges::range_value_t<Range>> arr(range);
+  const size_t pos = lower_bound(arr, value);
+  return pos < arr.size() && !(value < arr[pos]);
 }
 
 template <typename Derived>
@@ -41,7 +48,95 @@ struct Data : Searchable<Data<T, N>> {
   }
 };
 
-int main() {
+// Time per lookup of random keys for each search, on arrays from a few KiB
+// (L1) up to max_size elements, well past the last-level cache. The keys are
+// generated before timing; the sum of the results keeps the searches from
+// being optimized away and shows that they all agree.
+void benchmarkSearches(size_t max_size) {
+  constexpr size_t kQueries = 1 << 20;
+  std::mt19937_64 rng(42);
+
+  std::println("{:>10} {:>10} {:>12} {:>12} {:>12} {:>12}", "elements",
+               "KiB", "std", "lower_bound", "branchless", "eytzinger");
+  for (size_t n = 1 << 10; n <= max_size; n *= 4) {
+    std::vector<int32_t> sorted(n);
+    for (auto& value : sorted) value = static_cast<int32_t>(rng() >> 33);
+    std::ranges::sort(sorted);
+    const EytzingerSearch<int32_t> eytzinger(sorted);
+    std::vector<int32_t> queries(kQueries);
+    for (auto& query : queries) query = static_cast<int32_t>(rng() >> 33);
+
+    auto time = [&](auto search) {
+      size_t checksum = 0;
+      const auto start = std::chrono::steady_clock::now();
+      for (const int32_t query : queries) checksum += search(query);
+      const auto end = std::chrono::steady_clock::now();
+      const double ns =
+          std::chrono::duration<double, std::nano>(end - start).count();
+      return std::pair{ns / static_cast<double>(kQueries), checksum};
+    };
+    const auto [std_ns, expected] = time([&](int32_t query) {
+      return static_cast<size_t>(std::ranges::lower_bound(sorted, query) -
+                                 sorted.begin());
+    });
+    const auto [plain_ns, plain_sum] =
+        time([&](int32_t query) { return lower_bound(sorted, query); });
+    const auto [branchless_ns, branchless_sum] = time(
+        [&](int32_t query) { return branchless_lower_bound(sorted, query); });
+    const auto [eytzinger_ns, eytzinger_sum] =
+        time([&](int32_t query) { return eytzinger.lower_bound(query); });
+
+    const bool agree = plain_sum == expected && branchless_sum == expected &&
+                       eytzinger_sum == expected;
+    std::println("{:>10} {:>10} {:>9.1f} ns {:>9.1f} ns {:>9.1f} ns "
+                 "{:>9.1f} ns{}",
+                 n, n * sizeof(int32_t) / 1024, std_ns, plain_ns,
+                 branchless_ns, eytzinger_ns, agree ? "" : "  MISMATCH");
+  }
+}
+
+// Throughput of lower_bound_batch against the same queries answered one at a
+// time. The scalar column runs the lockstep groups without AVX2 gathers.
+void benchmarkBatch(size_t max_size) {
+  constexpr size_t kQueries = 1 << 21;
+  std::mt19937_64 rng(7);
+
+  std::println("{:>10} {:>12} {:>12} {:>12}", "elements", "one by one",
+               "scalar batch", "batch");
+  for (size_t n = 1 << 10; n <= max_size; n *= 4) {
+    std::vector<int32_t> sorted(n);
+    for (auto& value : sorted) value = static_cast<int32_t>(rng() >> 33);
+    std::ranges::sort(sorted);
+    std::vector<int32_t> queries(kQueries);
+    for (auto& query : queries) query = static_cast<int32_t>(rng() >> 33);
+    std::vector<size_t> expected(kQueries);
+    std::vector<size_t> out(kQueries);
+
+    auto time = [&](auto search) {
+      const auto start = std::chrono::steady_clock::now();
+      search();
+      const auto end = std::chrono::steady_clock::now();
+      return std::chrono::duration<double, std::nano>(end - start).count() /
+             static_cast<double>(kQueries);
+    };
+    const double single_ns = time([&] {
+      for (size_t i = 0; i < kQueries; ++i) {
+        expected[i] = branchless_lower_bound(sorted, queries[i]);
+      }
+    });
+    const double scalar_ns = time([&] {
+      binary_search_detail::lowerBoundGroups<int32_t>(sorted, queries, out);
+    });
+    bool agree = out == expected;
+    const double batch_ns =
+        time([&] { lower_bound_batch(sorted, queries, out); });
+    agree = agree && out == expected;
+    std::println("{:>10} {:>9.1f} ns {:>9.1f} ns {:>9.1f} ns{}", n, single_ns,
+                 scalar_ns, batch_ns, agree ? "" : "  MISMATCH");
+  }
+}
+
+int main(int argc, char* argv[]) {
   constexpr int target = 5;
 
   constexpr Data<int, 9> data = {{1, 2, 3, 4, 5, 6, 7, 8, 9}};
@@ -56,5 +151,21 @@ int main() {
     std::println("data[{}] = {}", index, value);
   }
 
-  return 0;
+  const std::vector<int> values = {1, 3, 3, 3, 5, 8, 13};
+  const auto [first, last] = equal_range(values, 3);
+  std::println("3 occupies positions [{}, {}); 4 would go at {}", first, last,
+               branchless_lower_bound(values, 4));
+  const EytzingerSearch<int> eytzinger(values);
+  std::println("Eytzinger lower_bound(8) = {}, upper_bound(13) = {}",
+               eytzinger.lower_bound(8), eytzinger.upper_bound(13));
+  const std::vector<int> keys = {0, 3, 9, 14};
+  std::vector<size_t> positions(keys.size());
+  lower_bound_batch(values, keys, positions);
+  std::println("lower_bound_batch({}) = {}", keys, positions);
+
+  // 2^24 int32 keys are 64 MiB, far beyond any last-level cache.
+  const size_t max_size = argc > 1 ? std::stoull(argv[1]) : size_t{1} << 24;
+  benchmarkSearches(max_size);
+  benchmarkBatch(max_size);
+  return EXIT_SUCCESS;
 }
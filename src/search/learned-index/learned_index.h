@@ -0,0 +1,244 @@
+#pragma once
+
+#include <algorithm>
+#include <concepts>
+#include <cstddef>
+#include <limits>
+#include <span>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+#include "linear_search.h"
+
+// Searches over sorted integer keys that use the values of the keys, not
+// just their order, to guess where a key is. Both return lower_bound
+// positions: the first element not less than the key, or keys.size().
+template <typename T>
+concept LearnedKey = std::integral<T> && !std::same_as<T, bool>;
+
+namespace learned_index_detail {
+
+// Ranges this short are finished with a SIMD scan.
+inline constexpr size_t kScanThreshold = 32;
+
+// b - a for a <= b, exact even when the signed difference would overflow.
+template <LearnedKey T>
+constexpr double distance(T a, T b) {
+  using U = std::make_unsigned_t<T>;
+  return static_cast<double>(static_cast<U>(static_cast<U>(b) -
+                                            static_cast<U>(a)));
+}
+
+// lower_bound within keys[first, last), which must contain it.
+template <LearnedKey T>
+size_t scan(std::span<const T> keys, size_t first, size_t last, T value) {
+  return first + simd_find_not_less(keys.subspan(first, last - first), value);
+}
+
+}  // namespace learned_index_detail
+
+// Interpolation search: guesses the position from where value falls between
+// the first and last key of the range, as one opens a dictionary near the
+// right letter. On uniformly distributed keys each guess shrinks the range
+// from n to about sqrt(n), so a search takes O(log log n) steps. A step that
+// fails to halve the range is followed by a plain bisection, which keeps the
+// worst case, e.g. exponentially growing keys, at O(log n).
+template <LearnedKey T>
+size_t interpolation_search(std::span<const T> keys,
+                            const std::type_identity_t<T>& value) {
+  using learned_index_detail::distance;
+  // keys[first - 1] < value <= keys[last] for keys that exist, so the answer
+  // is in [first, last].
+  size_t first = 0;
+  size_t last = keys.size();
+  bool bisect = false;
+  while (last - first > learned_index_detail::kScanThreshold) {
+    const T low = keys[first];
+    const T high = keys[last - 1];
+    if (!(low < value)) return first;
+    if (high < value) return last;
+    size_t probe = first + (last - first) / 2;
+    if (!bisect) {
+      const double fraction = distance(low, value) / distance(low, high);
+      const auto offset =
+          static_cast<size_t>(fraction * static_cast<double>(last - 1 - first));
+      probe = std::min(first + offset, last - 1);
+    }
+    const size_t before = last - first;
+    if (keys[probe] < value) {
+      first = probe + 1;
+    } else {
+      last = probe;
+    }
+    bisect = !bisect && last - first > before / 2;
+  }
+  return learned_index_detail::scan(keys, first, last, value);
+}
+
+// A piecewise-linear model of the position of each key, in the style of the
+// PGM-index. The sorted keys are cut into segments, each with a line
+// position = intercept + slope * (key - first key) that is off by at most
+// Epsilon for every key it covers. A lookup evaluates the line and scans the
+// 2 * Epsilon + 1 positions around the guess with SIMD compares.
+//
+// Finding the segment is the same problem on the segments' first keys, so
+// the model is built again over those, with a tighter error, until one
+// segment is left. Keys that are close to linear, e.g. timestamps at a
+// steady rate, fit in a handful of segments and one or two levels, and a
+// lookup costs little more than one multiplication and one short scan.
+//
+// The index keeps a view of the keys, which must outlive it.
+template <LearnedKey T, size_t Epsilon = 16>
+class LearnedIndex {
+ public:
+  LearnedIndex() = default;
+
+  // keys must be sorted; duplicates are allowed.
+  explicit LearnedIndex(std::span<const T> keys) : keys_(keys) {
+    if (!std::ranges::is_sorted(keys)) {
+      throw std::invalid_argument("LearnedIndex: keys must be sorted");
+    }
+    if (keys.empty()) return;
+    levels_.push_back(fit(dataPoints(keys), Epsilon));
+    while (levels_.back().keys.size() > 1) {
+      const std::vector<T>& below = levels_.back().keys;
+      std::vector<Point> points;
+      points.reserve(below.size());
+      for (size_t i = 0; i < below.size(); ++i) points.push_back({below[i], i});
+      levels_.push_back(fit(points, kUpperEpsilon));
+    }
+  }
+
+  [[nodiscard]] size_t lower_bound(const T& value) const {
+    if (levels_.empty()) return 0;
+    // Each upper level points to the segment below whose first key is the
+    // last one not greater than value.
+    size_t segment = 0;
+    for (size_t level = levels_.size() - 1; level > 0; --level) {
+      const std::vector<T>& below = levels_[level - 1].keys;
+      const size_t pos =
+          search(levels_[level], segment, below, value, kUpperEpsilon);
+      const bool exact = pos < below.size() && !(value < below[pos]);
+      segment = exact || pos == 0 ? pos : pos - 1;
+    }
+    return search(levels_[0], segment, keys_, value, Epsilon);
+  }
+
+  [[nodiscard]] size_t segments() const {
+    return levels_.empty() ? 0 : levels_[0].keys.size();
+  }
+  [[nodiscard]] size_t levels() const { return levels_.size(); }
+
+  // Memory used by the model, not counting the keys themselves.
+  [[nodiscard]] size_t size_in_bytes() const {
+    size_t segments = 0;
+    for (const Level& level : levels_) segments += level.keys.size();
+    return segments * (sizeof(T) + sizeof(Line));
+  }
+
+ private:
+  // Error bound of the levels above the first; they are small, so a tight
+  // bound costs little memory and keeps their scans short.
+  static constexpr size_t kUpperEpsilon = 4;
+
+  struct Point {
+    T key;
+    size_t position;
+  };
+
+  struct Line {
+    double slope;
+    size_t intercept;  // position of the segment's first key
+  };
+
+  // The first key of each segment and its line. The keys are kept apart so
+  // the next level up can scan them; the search there leaves the key of the
+  // chosen segment in cache, and its line shares one fetch.
+  struct Level {
+    std::vector<T> keys;
+    std::vector<Line> lines;
+  };
+
+  // The point (k, first position of k) for every distinct key. When k
+  // repeats, lower_bound jumps past all the copies just above k, so a second
+  // point (k + 1, end of the copies) pins the line there too.
+  static std::vector<Point> dataPoints(std::span<const T> keys) {
+    std::vector<Point> points;
+    for (size_t first = 0; first < keys.size();) {
+      const T key = keys[first];
+      size_t end = first + 1;
+      while (end < keys.size() && !(key < keys[end])) ++end;
+      points.push_back({key, first});
+      const bool repeated = end - first > 1;
+      if (repeated && key < std::numeric_limits<T>::max()) {
+        T above = key;
+        ++above;
+        if (end == keys.size() || above < keys[end]) {
+          points.push_back({above, end});
+        }
+      }
+      first = end;
+    }
+    return points;
+  }
+
+  // Greedy "shrinking cone": a segment starts at a point and keeps the range
+  // of slopes that pass within epsilon of every point added since. A point
+  // that would empty the range starts the next segment.
+  static Level fit(const std::vector<Point>& points, size_t epsilon) {
+    using learned_index_detail::distance;
+    const auto error = static_cast<double>(epsilon);
+    Level level;
+    size_t start = 0;
+    while (start < points.size()) {
+      const Point& origin = points[start];
+      double min_slope = 0;
+      double max_slope = std::numeric_limits<double>::infinity();
+      size_t next = start + 1;
+      for (; next < points.size(); ++next) {
+        const double dx = distance(origin.key, points[next].key);
+        const double dy = static_cast<double>(points[next].position) -
+                          static_cast<double>(origin.position);
+        const double low = std::max(min_slope, (dy - error) / dx);
+        const double high = std::min(max_slope, (dy + error) / dx);
+        if (low > high) break;
+        min_slope = low;
+        max_slope = high;
+      }
+      level.keys.push_back(origin.key);
+      level.lines.push_back(
+          {next == start + 1 ? 0 : (min_slope + max_slope) / 2,
+           origin.position});
+      start = next;
+    }
+    return level;
+  }
+
+  // lower_bound of value in keys, guessed by segment s of level and then
+  // scanned. The guess is clamped to the positions the segment covers, which
+  // also bounds values that fall between two segments.
+  static size_t search(const Level& level, size_t s, std::span<const T> keys,
+                       const T& value, size_t epsilon) {
+    using learned_index_detail::distance;
+    const Line& line = level.lines[s];
+    const size_t begin = line.intercept;
+    const size_t end = s + 1 < level.lines.size()
+                           ? level.lines[s + 1].intercept
+                           : keys.size();
+    size_t guess = begin;
+    if (level.keys[s] < value) {
+      const double offset = line.slope * distance(level.keys[s], value);
+      guess = offset < static_cast<double>(end - begin)
+                  ? begin + static_cast<size_t>(offset)
+                  : end;
+    }
+    // One more position on each side absorbs rounding of the guess.
+    const size_t first = guess > epsilon + 1 ? guess - epsilon - 1 : 0;
+    const size_t last = std::min(keys.size(), guess + epsilon + 2);
+    return learned_index_detail::scan(keys, first, last, value);
+  }
+
+  std::span<const T> keys_;
+  std::vector<Level> levels_;  // levels_[0] models keys_
+};
@@ -0,0 +1,114 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <limits>
+#include <print>
+#include <random>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "binary_search.h"
+#include "learned_index.h"
+
+// Compares lookups that learn from the key distribution with binary search
+// on sorted int64 keys of three shapes:
+// - timestamps: one event per millisecond with up to 1 ms of jitter, the
+//   near-linear case the learned index is made for;
+// - uniform: random keys, where interpolation search is at its best;
+// - lognormal: heavily skewed keys, where interpolation guesses badly and a
+//   piecewise model needs many segments.
+
+std::vector<int64_t> generateKeys(std::string_view shape, size_t n,
+                                  std::mt19937_64& rng) {
+  std::vector<int64_t> keys(n);
+  if (shape == "timestamps") {
+    constexpr int64_t kStart = 1'700'000'000'000'000'000;
+    constexpr int64_t kMillisecond = 1'000'000;
+    std::uniform_int_distribution<int64_t> jitter(0, kMillisecond - 1);
+    for (size_t i = 0; i < n; ++i) {
+      keys[i] = kStart + static_cast<int64_t>(i) * kMillisecond + jitter(rng);
+    }
+  } else if (shape == "uniform") {
+    for (auto& key : keys) key = static_cast<int64_t>(rng() >> 1);
+  } else {
+    std::lognormal_distribution<double> lognormal(0.0, 2.0);
+    for (auto& key : keys) {
+      key = static_cast<int64_t>(std::min(lognormal(rng) * 1e9, 9e18));
+    }
+  }
+  std::ranges::sort(keys);
+  return keys;
+}
+
+template <typename Search>
+std::pair<double, size_t> timeLookups(const std::vector<int64_t>& queries,
+                                      Search search) {
+  size_t checksum = 0;
+  const auto start = std::chrono::steady_clock::now();
+  for (const int64_t query : queries) checksum += search(query);
+  const auto end = std::chrono::steady_clock::now();
+  return {std::chrono::duration<double, std::nano>(end - start).count() /
+              static_cast<double>(queries.size()),
+          checksum};
+}
+
+void benchmark(std::string_view shape, size_t n) {
+  constexpr size_t kQueries = 1 << 20;
+  std::mt19937_64 rng(42);
+  const std::vector<int64_t> keys = generateKeys(shape, n, rng);
+  // Half the queries are keys that exist, half fall between keys.
+  std::vector<int64_t> queries(kQueries);
+  for (size_t q = 0; q < kQueries; ++q) {
+    const int64_t key = keys[rng() % n];
+    const bool between =
+        q % 2 == 1 && key < std::numeric_limits<int64_t>::max();
+    queries[q] = between ? key + 1 : key;
+  }
+
+  const auto build_start = std::chrono::steady_clock::now();
+  const LearnedIndex<int64_t> index(keys);
+  const std::chrono::duration<double, std::milli> build_time =
+      std::chrono::steady_clock::now() - build_start;
+
+  const auto [std_ns, expected] = timeLookups(queries, [&](int64_t query) {
+    return static_cast<size_t>(std::ranges::lower_bound(keys, query) -
+                               keys.begin());
+  });
+  const auto [branchless_ns, branchless_sum] =
+      timeLookups(queries, [&](int64_t query) {
+        return branchless_lower_bound(keys, query);
+      });
+  const auto [interpolation_ns, interpolation_sum] =
+      timeLookups(queries, [&](int64_t query) {
+        return interpolation_search(std::span<const int64_t>(keys), query);
+      });
+  const auto [learned_ns, learned_sum] = timeLookups(
+      queries, [&](int64_t query) { return index.lower_bound(query); });
+
+  const bool agree = branchless_sum == expected &&
+                     interpolation_sum == expected && learned_sum == expected;
+  std::println("{:<11}{:>9.1f} ns {:>9.1f} ns {:>9.1f} ns {:>9.1f} ns "
+               "{:>9} {:>3} {:>9.4f} B {:>7.1f} ms{}",
+               shape, std_ns, branchless_ns, interpolation_ns, learned_ns,
+               index.segments(), index.levels(),
+               static_cast<double>(index.size_in_bytes()) /
+                   static_cast<double>(n),
+               build_time.count(), agree ? "" : "  MISMATCH");
+}
+
+int main(int argc, char* argv[]) {
+  const size_t n = argc > 1 ? std::stoull(argv[1]) : 10'000'000;
+  std::println("{} sorted int64 keys, lookup latency and model size:", n);
+  std::println("{:<11}{:>12} {:>12} {:>12} {:>12} {:>9} {:>3} {:>11} {:>10}",
+               "keys", "std", "branchless", "interpolate", "learned",
+               "segments", "lvl", "bytes/key", "build");
+  for (const std::string_view shape : {"timestamps", "uniform", "lognormal"}) {
+    benchmark(shape, n);
+  }
+  return EXIT_SUCCESS;
+}
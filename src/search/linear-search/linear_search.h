@@ -0,0 +1,321 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <type_traits>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+// Linear searches that compare a whole vector of elements per step. Each step
+// loads 16 or 32 bytes, compares every lane with the value, turns the result
+// into a bit mask with movemask (one bit per byte, so sizeof(T) bits per
+// element) and, if any bit is set, finds the first match with countr_zero.
+// One predictable branch per vector replaces one per element.
+//
+// Every search returns the position of the first match, or arr.size():
+// - simd_find: first element equal to value.
+// - simd_find_less: first element less than value.
+// - simd_find_not_less: first element not less than value; on a sorted array
+//   this is lower_bound.
+// simd_memchr is memchr on top of the byte kernel.
+//
+// Arrays of at least 32 bytes use AVX2; shorter ones use SSE. A tail that does
+// not fill a vector is handled by one more load that ends at the last element
+// and overlaps lanes that have already been checked. Without AVX2, or during
+// constant evaluation, the searches run one element at a time.
+template <typename T>
+concept SimdFindable =
+    ((std::integral<T> && !std::same_as<T, bool>) ||
+     std::same_as<T, float> || std::same_as<T, double> ||
+     std::same_as<T, std::byte>) &&
+    (sizeof(T) == 1 || sizeof(T) == 2 || sizeof(T) == 4 || sizeof(T) == 8);
+
+namespace linear_search_detail {
+
+enum class Predicate { kEqual, kLess, kNotLess };
+
+template <Predicate P, typename T>
+constexpr bool matches(const T& element, const T& value) {
+  if constexpr (P == Predicate::kEqual) {
+    return element == value;
+  } else if constexpr (P == Predicate::kLess) {
+    return element < value;
+  } else {
+    return !(element < value);
+  }
+}
+
+#if defined(__AVX2__)
+// Integers of the element's size, for broadcasting its bit pattern.
+template <typename T>
+using LaneBits = std::conditional_t<
+    sizeof(T) == 1, char,
+    std::conditional_t<sizeof(T) == 2, short,
+                       std::conditional_t<sizeof(T) == 4, int, long long>>>;
+
+// Integer compares are signed; flipping the sign bit of both sides orders
+// unsigned lanes the same way.
+template <typename T>
+inline constexpr bool kUnsignedLanes =
+    std::is_unsigned_v<T> || std::same_as<T, std::byte>;
+
+// 32-byte AVX2 vectors. Float lanes are kept in integer registers and only
+// reinterpreted for the compare.
+template <typename T>
+struct Wide {
+  using Vector = __m256i;
+  static constexpr size_t kLanes = 32 / sizeof(T);
+  static constexpr uint32_t kFullMask = 0xFFFFFFFF;
+
+  static Vector load(const T* p) {
+    return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+  }
+
+  static Vector broadcast(T value) {
+    const auto bits = std::bit_cast<LaneBits<T>>(value);
+    if constexpr (sizeof(T) == 1) {
+      return _mm256_set1_epi8(bits);
+    } else if constexpr (sizeof(T) == 2) {
+      return _mm256_set1_epi16(bits);
+    } else if constexpr (sizeof(T) == 4) {
+      return _mm256_set1_epi32(bits);
+    } else {
+      return _mm256_set1_epi64x(bits);
+    }
+  }
+
+  static Vector equal(Vector a, Vector b) {
+    if constexpr (std::same_as<T, float>) {
+      return _mm256_castps_si256(_mm256_cmp_ps(
+          _mm256_castsi256_ps(a), _mm256_castsi256_ps(b), _CMP_EQ_OQ));
+    } else if constexpr (std::same_as<T, double>) {
+      return _mm256_castpd_si256(_mm256_cmp_pd(
+          _mm256_castsi256_pd(a), _mm256_castsi256_pd(b), _CMP_EQ_OQ));
+    } else if constexpr (sizeof(T) == 1) {
+      return _mm256_cmpeq_epi8(a, b);
+    } else if constexpr (sizeof(T) == 2) {
+      return _mm256_cmpeq_epi16(a, b);
+    } else if constexpr (sizeof(T) == 4) {
+      return _mm256_cmpeq_epi32(a, b);
+    } else {
+      return _mm256_cmpeq_epi64(a, b);
+    }
+  }
+
+  // All ones in the lanes where a < b.
+  static Vector less(Vector a, Vector b) {
+    if constexpr (std::same_as<T, float>) {
+      return _mm256_castps_si256(_mm256_cmp_ps(
+          _mm256_castsi256_ps(a), _mm256_castsi256_ps(b), _CMP_LT_OQ));
+    } else if constexpr (std::same_as<T, double>) {
+      return _mm256_castpd_si256(_mm256_cmp_pd(
+          _mm256_castsi256_pd(a), _mm256_castsi256_pd(b), _CMP_LT_OQ));
+    } else {
+      if constexpr (kUnsignedLanes<T>) {
+        const Vector sign = Wide<std::make_signed_t<LaneBits<T>>>::broadcast(
+            std::numeric_limits<std::make_signed_t<LaneBits<T>>>::min());
+        a = _mm256_xor_si256(a, sign);
+        b = _mm256_xor_si256(b, sign);
+      }
+      if constexpr (sizeof(T) == 1) {
+        return _mm256_cmpgt_epi8(b, a);
+      } else if constexpr (sizeof(T) == 2) {
+        return _mm256_cmpgt_epi16(b, a);
+      } else if constexpr (sizeof(T) == 4) {
+        return _mm256_cmpgt_epi32(b, a);
+      } else {
+        return _mm256_cmpgt_epi64(b, a);
+      }
+    }
+  }
+
+  static uint32_t mask(Vector v) {
+    return static_cast<uint32_t>(_mm256_movemask_epi8(v));
+  }
+  static Vector combine(Vector a, Vector b) { return _mm256_or_si256(a, b); }
+};
+
+// 16-byte SSE vectors, for arrays shorter than one AVX2 vector.
+template <typename T>
+struct Narrow {
+  using Vector = __m128i;
+  static constexpr size_t kLanes = 16 / sizeof(T);
+  static constexpr uint32_t kFullMask = 0xFFFF;
+
+  static Vector load(const T* p) {
+    return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+  }
+
+  static Vector broadcast(T value) {
+    const auto bits = std::bit_cast<LaneBits<T>>(value);
+    if constexpr (sizeof(T) == 1) {
+      return _mm_set1_epi8(bits);
+    } else if constexpr (sizeof(T) == 2) {
+      return _mm_set1_epi16(bits);
+    } else if constexpr (sizeof(T) == 4) {
+      return _mm_set1_epi32(bits);
+    } else {
+      return _mm_set1_epi64x(bits);
+    }
+  }
+
+  static Vector equal(Vector a, Vector b) {
+    if constexpr (std::same_as<T, float>) {
+      return _mm_castps_si128(
+          _mm_cmp_ps(_mm_castsi128_ps(a), _mm_castsi128_ps(b), _CMP_EQ_OQ));
+    } else if constexpr (std::same_as<T, double>) {
+      return _mm_castpd_si128(
+          _mm_cmp_pd(_mm_castsi128_pd(a), _mm_castsi128_pd(b), _CMP_EQ_OQ));
+    } else if constexpr (sizeof(T) == 1) {
+      return _mm_cmpeq_epi8(a, b);
+    } else if constexpr (sizeof(T) == 2) {
+      return _mm_cmpeq_epi16(a, b);
+    } else if constexpr (sizeof(T) == 4) {
+      return _mm_cmpeq_epi32(a, b);
+    } else {
+      return _mm_cmpeq_epi64(a, b);
+    }
+  }
+
+  static Vector less(Vector a, Vector b) {
+    if constexpr (std::same_as<T, float>) {
+      return _mm_castps_si128(
+          _mm_cmp_ps(_mm_castsi128_ps(a), _mm_castsi128_ps(b), _CMP_LT_OQ));
+    } else if constexpr (std::same_as<T, double>) {
+      return _mm_castpd_si128(
+          _mm_cmp_pd(_mm_castsi128_pd(a), _mm_castsi128_pd(b), _CMP_LT_OQ));
+    } else {
+      if constexpr (kUnsignedLanes<T>) {
+        const Vector sign = Narrow<std::make_signed_t<LaneBits<T>>>::broadcast(
+            std::numeric_limits<std::make_signed_t<LaneBits<T>>>::min());
+        a = _mm_xor_si128(a, sign);
+        b = _mm_xor_si128(b, sign);
+      }
+      if constexpr (sizeof(T) == 1) {
+        return _mm_cmpgt_epi8(b, a);
+      } else if constexpr (sizeof(T) == 2) {
+        return _mm_cmpgt_epi16(b, a);
+      } else if constexpr (sizeof(T) == 4) {
+        return _mm_cmpgt_epi32(b, a);
+      } else {
+        return _mm_cmpgt_epi64(b, a);
+      }
+    }
+  }
+
+  static uint32_t mask(Vector v) {
+    return static_cast<uint32_t>(_mm_movemask_epi8(v));
+  }
+  static Vector combine(Vector a, Vector b) { return _mm_or_si128(a, b); }
+};
+
+// Lanes of x that are equal to or less than value, as a compare result.
+template <typename V, Predicate P>
+typename V::Vector compare(typename V::Vector x, typename V::Vector value) {
+  if constexpr (P == Predicate::kEqual) {
+    return V::equal(x, value);
+  } else {
+    return V::less(x, value);
+  }
+}
+
+// Bits of the lanes that satisfy the predicate. Not-less is the complement
+// of less, which also matches NaN elements the way !(element < value) does.
+template <typename V, Predicate P>
+uint32_t matchMask(typename V::Vector x, typename V::Vector value) {
+  const uint32_t mask = V::mask(compare<V, P>(x, value));
+  return P == Predicate::kNotLess ? ~mask & V::kFullMask : mask;
+}
+
+// Needs arr.size() >= V::kLanes.
+template <typename V, Predicate P, typename T>
+size_t findVectors(std::span<const T> arr, T value) {
+  constexpr size_t kLanes = V::kLanes;
+  const auto needle = V::broadcast(value);
+  const T* data = arr.data();
+  const size_t n = arr.size();
+  auto firstMatch = [](size_t offset, uint32_t mask) {
+    return offset + static_cast<size_t>(std::countr_zero(mask)) / sizeof(T);
+  };
+
+  size_t i = 0;
+  // Long arrays test four vectors per branch, like memchr implementations
+  // do, then rescan the block that matched one vector at a time.
+  if constexpr (P != Predicate::kNotLess) {
+    for (; i + 4 * kLanes <= n; i += 4 * kLanes) {
+      const auto any = V::combine(
+          V::combine(compare<V, P>(V::load(data + i), needle),
+                     compare<V, P>(V::load(data + i + kLanes), needle)),
+          V::combine(compare<V, P>(V::load(data + i + 2 * kLanes), needle),
+                     compare<V, P>(V::load(data + i + 3 * kLanes), needle)));
+      if (V::mask(any) != 0) break;
+    }
+  }
+  for (; i + kLanes <= n; i += kLanes) {
+    const uint32_t mask = matchMask<V, P>(V::load(data + i), needle);
+    if (mask != 0) return firstMatch(i, mask);
+  }
+  if (i == n) return n;
+  // Lanes before i in the last vector were checked already and did not match.
+  const size_t last = n - kLanes;
+  const uint32_t mask = matchMask<V, P>(V::load(data + last), needle);
+  return mask != 0 ? firstMatch(last, mask) : n;
+}
+#endif
+
+template <Predicate P, typename T>
+constexpr size_t findFirst(std::span<const T> arr, const T& value) {
+#if defined(__AVX2__)
+  if constexpr (SimdFindable<T>) {
+    if !consteval {
+      if (arr.size() >= Wide<T>::kLanes) {
+        return findVectors<Wide<T>, P>(arr, value);
+      }
+      if (arr.size() >= Narrow<T>::kLanes) {
+        return findVectors<Narrow<T>, P>(arr, value);
+      }
+    }
+  }
+#endif
+  for (size_t i = 0; i < arr.size(); ++i) {
+    if (matches<P>(arr[i], value)) return i;
+  }
+  return arr.size();
+}
+
+}  // namespace linear_search_detail
+
+template <std::totally_ordered T>
+constexpr size_t simd_find(std::span<const T> arr,
+                           const std::type_identity_t<T>& value) {
+  using linear_search_detail::Predicate;
+  return linear_search_detail::findFirst<Predicate::kEqual>(arr, value);
+}
+
+template <std::totally_ordered T>
+constexpr size_t simd_find_less(std::span<const T> arr,
+                                const std::type_identity_t<T>& value) {
+  using linear_search_detail::Predicate;
+  return linear_search_detail::findFirst<Predicate::kLess>(arr, value);
+}
+
+template <std::totally_ordered T>
+constexpr size_t simd_find_not_less(std::span<const T> arr,
+                                    const std::type_identity_t<T>& value) {
+  using linear_search_detail::Predicate;
+  return linear_search_detail::findFirst<Predicate::kNotLess>(arr, value);
+}
+
+// Same contract as std::memchr.
+inline const void* simd_memchr(const void* data, int ch, size_t size) {
+  const std::span bytes(static_cast<const unsigned char*>(data), size);
+  const size_t pos = simd_find(bytes, static_cast<unsigned char>(ch));
+  return pos == size ? nullptr : bytes.data() + pos;
+}
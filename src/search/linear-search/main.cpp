@@ -1,18 +1,35 @@
+#include <algorithm>
 #include <array>
 #include <cassert>
+#include <chrono>
 #include <concepts>
 #include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
 #include <print>
+#include <random>
 #include <ranges>
+#include <span>
 #include <utility>
+#include <vector>
+
+#include "linear_search.h"
 
 template <typename T>
 concept Comparable = std::totally_ordered<T>;
 
 template <std::ranges::input_range Range, Comparable T>
 constexpr auto linear_search(Range&& range, const T& value) noexcept {
-  return std::ranges::find(std::forward<Range>(range), value) !=
-         std::ranges::end(range);
+  using Element = std::ranges::range_value_t<Range>;
+  if constexpr (std::ranges::contiguous_range<Range> &&
+                SimdFindable<Element>) {
+    const std::span<const Element> arr(range);
+    return simd_find(arr, value) != arr.size();
+  } else {
+    return std::ranges::find(std::forward<Range>(range), value) !=
+           std::ranges::end(range);
+  }
 }
 
 template <typename Derived>
@@ -39,6 +56,90 @@ struct Data : Searchable<Data<T, N>> {
   }
 };
 
+// Average time of one search over many arrays of the same size, with the
+// target at a random position or missing. Many arrays are cycled so the
+// branch predictor cannot learn where the match is.
+template <typename T, typename Search>
+double timeSearch(size_t n, Search search) {
+  constexpr size_t kArrays = 256;
+  constexpr size_t kSearches = 1 << 20;
+  std::mt19937_64 rng(n);
+  std::vector<std::vector<T>> arrays(kArrays, std::vector<T>(n));
+  std::vector<T> targets(kArrays);
+  for (size_t a = 0; a < kArrays; ++a) {
+    for (size_t i = 0; i < n; ++i) arrays[a][i] = static_cast<T>(2 * i + 2);
+    targets[a] = static_cast<T>(2 * (rng() % (n + n / 8 + 1)) + 2);
+  }
+
+  size_t checksum = 0;
+  const auto start = std::chrono::steady_clock::now();
+  for (size_t s = 0; s < kSearches; ++s) {
+    const size_t a = s % kArrays;
+    checksum += search(std::span<const T>(arrays[a]), targets[a]);
+  }
+  const auto end = std::chrono::steady_clock::now();
+  if (checksum == 0) std::println("(no matches)");
+  return std::chrono::duration<double, std::nano>(end - start).count() /
+         static_cast<double>(kSearches);
+}
+
+void benchmarkSmallArrays() {
+  std::println("{:>8} {:>14} {:>14} {:>14} {:>14}", "elements", "find int32",
+               "simd int32", "find float", "simd float");
+  for (const size_t n :
+       std::to_array<size_t>({4, 8, 16, 24, 32, 48, 64, 256})) {
+    auto find = []<typename T>(std::span<const T> arr, T target) {
+      return static_cast<size_t>(std::ranges::find(arr, target) - arr.begin());
+    };
+    auto simd = []<typename T>(std::span<const T> arr, T target) {
+      return simd_find(arr, target);
+    };
+    std::println("{:>8} {:>11.2f} ns {:>11.2f} ns {:>11.2f} ns {:>11.2f} ns",
+                 n, timeSearch<int32_t>(n, find), timeSearch<int32_t>(n, simd),
+                 timeSearch<float>(n, find), timeSearch<float>(n, simd));
+  }
+}
+
+// Scans a buffer for a byte that only occurs at its end. Every repetition
+// starts at a different offset, so the calls cannot be merged.
+void benchmarkMemchr() {
+  constexpr size_t kRepetitions = 64;
+  std::println("{:>10} {:>14} {:>14} {:>14}", "bytes", "find", "memchr",
+               "simd_memchr");
+  for (const size_t n : std::to_array<size_t>({64, 4096, 1 << 20})) {
+    std::vector<char> text(n - 1, 'a');
+    text.push_back('z');
+    auto time = [&](auto search) {
+      size_t checksum = 0;
+      size_t scanned = 0;
+      const auto start = std::chrono::steady_clock::now();
+      for (size_t r = 0; r < kRepetitions; ++r) {
+        const size_t offset = r % 16;
+        const auto* found = static_cast<const char*>(
+            search(text.data() + offset, n - offset));
+        checksum += static_cast<size_t>(found - text.data());
+        scanned += n - offset;
+      }
+      const auto end = std::chrono::steady_clock::now();
+      if (checksum != kRepetitions * (n - 1)) std::println("(mismatch)");
+      // GB/s is bytes per nanosecond.
+      return static_cast<double>(scanned) /
+             std::chrono::duration<double, std::nano>(end - start).count();
+    };
+    const double find_gbs = time([](const char* data, size_t size) {
+      return static_cast<const void*>(std::find(data, data + size, 'z'));
+    });
+    const double memchr_gbs = time([](const char* data, size_t size) {
+      return std::memchr(data, 'z', size);
+    });
+    const double simd_gbs = time([](const char* data, size_t size) {
+      return simd_memchr(data, 'z', size);
+    });
+    std::println("{:>10} {:>9.1f} GB/s {:>9.1f} GB/s {:>9.1f} GB/s", n,
+                 find_gbs, memchr_gbs, simd_gbs);
+  }
+}
+
 int main() {
   constexpr int target = 5;
 
@@ -53,5 +154,12 @@ int main() {
     std::println("data[{}] = {}", index, value);
   }
 
-  return 0;
+  const std::vector<float> readings = {0.5F, 1.5F, 0.25F, 4.0F, 2.0F};
+  const std::span<const float> view(readings);
+  std::println("First reading below 0.3 is at {}, first of at least 3 at {}",
+               simd_find_less(view, 0.3F), simd_find_not_less(view, 3.0F));
+
+  benchmarkSmallArrays();
+  benchmarkMemchr();
+  return EXIT_SUCCESS;
 }
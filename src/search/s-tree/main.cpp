@@ -0,0 +1,112 @@
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <chrono>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <print>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "binary_search.h"
+#include "s_tree.h"
+
+template <typename Derived>
+struct Searchable {
+  [[nodiscard]] auto contains(const auto& value) const {
+    return static_cast<const Derived&>(*this).tree.contains(value);
+  }
+};
+
+// Sorts its elements once and answers membership through an S+-tree.
+template <STreeKey T, std::size_t N>
+struct Data : Searchable<Data<T, N>> {
+  std::array<T, N> arr;
+  STree<T> tree;
+
+  // cppcheck-suppress noExplicitConstructor
+  // NOLINTNEXTLINE(google-explicit-constructor)
+  Data(std::array<T, N> init_arr) : arr(std::move(init_arr)) {
+    std::ranges::sort(arr);
+    tree = STree<T>(arr);
+  }
+
+  [[nodiscard]] auto begin() const noexcept { return arr.begin(); }
+  [[nodiscard]] auto end() const noexcept { return arr.end(); }
+  [[nodiscard]] auto operator[](std::size_t index) const -> const T& {
+    assert(index < N && "Index out of bounds");
+    return arr[index];
+  }
+};
+
+// Random lookups in sorted int32 arrays from 1 Ki elements up to max_size,
+// so the last sizes are far beyond the last-level cache.
+void benchmarkSearches(size_t max_size) {
+  constexpr size_t kQueries = 1 << 20;
+  std::mt19937_64 rng(42);
+
+  std::println("{:>10} {:>6} {:>12} {:>12} {:>12} {:>12}", "elements",
+               "height", "std", "branchless", "eytzinger", "s-tree");
+  for (size_t n = 1 << 10; n <= max_size; n *= 4) {
+    std::vector<int32_t> sorted(n);
+    for (auto& value : sorted) value = static_cast<int32_t>(rng() >> 33);
+    std::ranges::sort(sorted);
+    const EytzingerSearch<int32_t> eytzinger(sorted);
+    const STree<int32_t> tree(sorted);
+    std::vector<int32_t> queries(kQueries);
+    for (auto& query : queries) query = static_cast<int32_t>(rng() >> 33);
+
+    auto time = [&](auto search) {
+      size_t checksum = 0;
+      const auto start = std::chrono::steady_clock::now();
+      for (const int32_t query : queries) checksum += search(query);
+      const auto end = std::chrono::steady_clock::now();
+      const double ns =
+          std::chrono::duration<double, std::nano>(end - start).count();
+      return std::pair{ns / static_cast<double>(kQueries), checksum};
+    };
+    const auto [std_ns, expected] = time([&](int32_t query) {
+      return static_cast<size_t>(std::ranges::lower_bound(sorted, query) -
+                                 sorted.begin());
+    });
+    const auto [branchless_ns, branchless_sum] = time(
+        [&](int32_t query) { return branchless_lower_bound(sorted, query); });
+    const auto [eytzinger_ns, eytzinger_sum] =
+        time([&](int32_t query) { return eytzinger.lower_bound(query); });
+    const auto [tree_ns, tree_sum] =
+        time([&](int32_t query) { return tree.lower_bound(query); });
+
+    const bool agree = branchless_sum == expected &&
+                       eytzinger_sum == expected && tree_sum == expected;
+    std::println("{:>10} {:>6} {:>9.1f} ns {:>9.1f} ns {:>9.1f} ns "
+                 "{:>9.1f} ns{}",
+                 n, tree.height(), std_ns, branchless_ns, eytzinger_ns,
+                 tree_ns, agree ? "" : "  MISMATCH");
+  }
+}
+
+int main(int argc, char* argv[]) {
+  constexpr int target = 5;
+
+  const Data<int, 9> data = {{9, 3, 7, 1, 5, 2, 8, 4, 6}};
+  if (data.contains(target)) {
+    std::println("Found {} in the array.", target);
+  } else {
+    std::println("Did not find {} in the array.", target);
+  }
+
+  const std::vector<float> prices = {0.5F, 1.25F, 1.25F, 2.0F, 3.5F, 8.0F};
+  const STree<float> tree(prices);
+  std::println("{} prices in a tree of height {}; the first not below 1.25 "
+               "is at {}, the first above 9 at {}",
+               tree.size(), tree.height(), tree.lower_bound(1.25F),
+               tree.lower_bound(9.0F));
+
+  const size_t max_size = argc > 1 ? std::stoull(argv[1]) : 1 << 24;
+  benchmarkSearches(max_size);
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,159 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <stdexcept>
+#include <vector>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+// Static search tree in B+-tree layout (an "S+-tree"), built once from sorted
+// keys. Every node is one cache line of keys: 16 keys for 4-byte types. The
+// bottom layer holds the keys themselves, in order, padded to whole nodes;
+// each layer above holds, for every child but the first, the smallest key
+// under it. A node of layer h with index k has children k * (B + 1) + i,
+// so there are no pointers, and the tree of 10 million int32 keys is only
+// six levels deep where binary search takes 23 steps.
+//
+// At each level the search counts the keys in the node that are less than
+// the value. That count is the child to descend into, and at the bottom it
+// is the offset of lower_bound in the node. With AVX2, int32 and float nodes
+// are counted with two 8-lane compares, a movemask and a popcount, so a
+// level costs one cache miss and no branch.
+template <typename T>
+concept STreeKey =
+    std::totally_ordered<T> && std::numeric_limits<T>::is_specialized;
+
+template <STreeKey T>
+class STree {
+ public:
+  // Keys per node: one 64-byte cache line.
+  static constexpr size_t kNodeKeys = std::max<size_t>(1, 64 / sizeof(T));
+
+  // An empty tree still has its one padding node, so lookups need no check.
+  STree() : STree(std::span<const T>{}) {}
+
+  // keys must be sorted; duplicates are allowed.
+  explicit STree(std::span<const T> keys) : size_(keys.size()) {
+    if (!std::ranges::is_sorted(keys)) {
+      throw std::invalid_argument("STree: keys must be sorted");
+    }
+    // Layer sizes in nodes, bottom up, until a layer fits in one node.
+    std::vector<size_t> layer_nodes = {
+        std::max<size_t>(1, (keys.size() + kNodeKeys - 1) / kNodeKeys)};
+    while (layer_nodes.back() > 1) {
+      layer_nodes.push_back((layer_nodes.back() + kNodeKeys) /
+                            (kNodeKeys + 1));
+    }
+    // Stored top down, so the hot upper layers sit next to each other.
+    layer_offsets_.resize(layer_nodes.size());
+    size_t total = 0;
+    for (size_t h = layer_nodes.size(); h-- > 0;) {
+      layer_offsets_[h] = total;
+      total += layer_nodes[h];
+    }
+    nodes_.resize(total);
+
+    Node* const bottom = nodes_.data() + layer_offsets_[0];
+    for (size_t i = 0; i < layer_nodes[0] * kNodeKeys; ++i) {
+      bottom[i / kNodeKeys].keys[i % kNodeKeys] =
+          i < keys.size() ? keys[i] : kPadding;
+    }
+    // Key j of node k in layer h is the first key under child j + 1, found
+    // by always taking the first child down to the bottom layer.
+    for (size_t h = 1; h < layer_nodes.size(); ++h) {
+      for (size_t k = 0; k < layer_nodes[h]; ++k) {
+        for (size_t j = 0; j < kNodeKeys; ++j) {
+          size_t leaf = k * (kNodeKeys + 1) + j + 1;
+          for (size_t level = 1; level < h; ++level) leaf *= kNodeKeys + 1;
+          nodes_[layer_offsets_[h] + k].keys[j] =
+              leaf < layer_nodes[0] ? bottom[leaf].keys[0] : kPadding;
+        }
+      }
+    }
+  }
+
+  // Position of the first key not less than value, or size().
+  [[nodiscard]] size_t lower_bound(const T& value) const {
+    size_t k = 0;
+    for (size_t h = layer_offsets_.size() - 1; h > 0; --h) {
+      const Node& node = nodes_[layer_offsets_[h] + k];
+      k = k * (kNodeKeys + 1) + countLess(node, value);
+    }
+    const size_t pos =
+        k * kNodeKeys + countLess(nodes_[layer_offsets_[0] + k], value);
+    return std::min(pos, size_);
+  }
+
+  [[nodiscard]] bool contains(const T& value) const {
+    const size_t pos = lower_bound(value);
+    return pos < size_ && !(value < key(pos));
+  }
+
+  // The key at a position of the sorted order.
+  [[nodiscard]] const T& key(size_t pos) const {
+    return nodes_[layer_offsets_[0] + pos / kNodeKeys].keys[pos % kNodeKeys];
+  }
+
+  [[nodiscard]] size_t size() const noexcept { return size_; }
+  [[nodiscard]] bool empty() const noexcept { return size_ == 0; }
+  [[nodiscard]] size_t height() const noexcept {
+    return layer_offsets_.size();
+  }
+
+ private:
+  // Fills the unused slots; no value is counted as greater than it.
+  static constexpr T kPadding = std::numeric_limits<T>::has_infinity
+                                    ? std::numeric_limits<T>::infinity()
+                                    : std::numeric_limits<T>::max();
+
+  struct alignas(64) Node {
+    T keys[kNodeKeys];
+  };
+
+  static size_t countLess(const Node& node, const T& value) {
+#if defined(__AVX2__)
+    if constexpr ((std::same_as<T, int32_t> || std::same_as<T, float>) &&
+                  kNodeKeys == 16) {
+      return countLessAvx2(node, value);
+    }
+#endif
+    size_t count = 0;
+    for (const T& key : node.keys) count += static_cast<size_t>(key < value);
+    return count;
+  }
+
+#if defined(__AVX2__)
+  static size_t countLessAvx2(const Node& node, const T& value) {
+    __m256 low;
+    __m256 high;
+    if constexpr (std::same_as<T, float>) {
+      const __m256 needle = _mm256_set1_ps(value);
+      low = _mm256_cmp_ps(_mm256_load_ps(node.keys), needle, _CMP_LT_OQ);
+      high = _mm256_cmp_ps(_mm256_load_ps(node.keys + 8), needle, _CMP_LT_OQ);
+    } else {
+      const __m256i needle = _mm256_set1_epi32(value);
+      const auto* lanes = reinterpret_cast<const __m256i*>(node.keys);
+      low = _mm256_castsi256_ps(
+          _mm256_cmpgt_epi32(needle, _mm256_load_si256(lanes)));
+      high = _mm256_castsi256_ps(
+          _mm256_cmpgt_epi32(needle, _mm256_load_si256(lanes + 1)));
+    }
+    const auto mask = static_cast<uint32_t>(_mm256_movemask_ps(low)) |
+                      static_cast<uint32_t>(_mm256_movemask_ps(high)) << 8;
+    return static_cast<size_t>(std::popcount(mask));
+  }
+#endif
+
+  size_t size_ = 0;
+  std::vector<Node> nodes_;
+  // Index in nodes_ of the first node of each layer; layer 0 is the bottom.
+  std::vector<size_t> layer_offsets_;
+};
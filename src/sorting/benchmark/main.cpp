@@ -0,0 +1,381 @@
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <compare>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <format>
+#include <fstream>
+#include <functional>
+#include <limits>
+#include <optional>
+#include <print>
+#include <random>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "bubble_sort.h"
+#include "parallel_sort.h"
+#include "pdq_sort.h"
+#include "quick_sort.h"
+#include "radix_sort.h"
+
+// Runs every sort in the project on a grid of input sizes and shapes and
+// reports time per element, comparisons and element moves. Results can be
+// written as CSV or JSON and compared between builds to catch regressions.
+//
+//   sorting-benchmark [--min-size N] [--max-size N] [--swaps K]
+//                     [--csv FILE] [--json FILE]
+
+// An int32 key that counts how often it is compared and moved. Sorting a
+// vector of these gives the operation counts; timing uses plain ints.
+struct Counted {
+  static inline std::atomic<uint64_t> comparisons{0};
+  static inline std::atomic<uint64_t> moves{0};
+
+  int32_t value = 0;
+
+  Counted() = default;
+  explicit Counted(int32_t v) : value(v) {}
+  Counted(const Counted& other) : value(other.value) { count(moves); }
+  Counted(Counted&& other) noexcept : value(other.value) { count(moves); }
+  Counted& operator=(const Counted& other) {
+    value = other.value;
+    count(moves);
+    return *this;
+  }
+  Counted& operator=(Counted&& other) noexcept {
+    value = other.value;
+    count(moves);
+    return *this;
+  }
+  ~Counted() = default;
+
+  friend bool operator==(const Counted& a, const Counted& b) {
+    count(comparisons);
+    return a.value == b.value;
+  }
+  friend std::strong_ordering operator<=>(const Counted& a, const Counted& b) {
+    count(comparisons);
+    return a.value <=> b.value;
+  }
+
+  static void reset() {
+    comparisons = 0;
+    moves = 0;
+  }
+
+ private:
+  static void count(std::atomic<uint64_t>& counter) {
+    counter.fetch_add(1, std::memory_order_relaxed);
+  }
+};
+
+enum class Distribution {
+  kRandom,
+  kSorted,
+  kReverse,
+  kOrganPipe,
+  kFewUnique,
+  kZipfian,
+  kNearlySorted,
+};
+
+constexpr std::array kDistributions = {
+    Distribution::kRandom,       Distribution::kSorted,
+    Distribution::kReverse,      Distribution::kOrganPipe,
+    Distribution::kFewUnique,    Distribution::kZipfian,
+    Distribution::kNearlySorted,
+};
+
+constexpr std::string_view name(Distribution distribution) {
+  switch (distribution) {
+    case Distribution::kRandom:
+      return "random";
+    case Distribution::kSorted:
+      return "sorted";
+    case Distribution::kReverse:
+      return "reverse";
+    case Distribution::kOrganPipe:
+      return "organ-pipe";
+    case Distribution::kFewUnique:
+      return "few-unique";
+    case Distribution::kZipfian:
+      return "zipfian";
+    case Distribution::kNearlySorted:
+      return "nearly-sorted";
+  }
+  return "unknown";
+}
+
+// swaps is the number of random transpositions for kNearlySorted.
+std::vector<int32_t> generate(Distribution distribution, size_t n,
+                              size_t swaps, std::mt19937_64& rng) {
+  std::vector<int32_t> values(n);
+  auto index = [](size_t i) { return static_cast<int32_t>(i); };
+  switch (distribution) {
+    case Distribution::kRandom:
+      for (auto& value : values) value = static_cast<int32_t>(rng());
+      break;
+    case Distribution::kSorted:
+      for (size_t i = 0; i < n; ++i) values[i] = index(i);
+      break;
+    case Distribution::kReverse:
+      for (size_t i = 0; i < n; ++i) values[i] = index(n - i);
+      break;
+    case Distribution::kOrganPipe:
+      for (size_t i = 0; i < n; ++i) values[i] = index(std::min(i, n - i));
+      break;
+    case Distribution::kFewUnique:
+      for (auto& value : values) value = static_cast<int32_t>(rng() % 16);
+      break;
+    case Distribution::kZipfian: {
+      // Rank k is drawn with probability proportional to 1 / k, so a few
+      // keys dominate and there is a long tail of rare ones.
+      const size_t ranks = std::clamp<size_t>(n, 1, size_t{1} << 20);
+      std::vector<double> cdf(ranks);
+      double sum = 0;
+      for (size_t k = 0; k < ranks; ++k) {
+        sum += 1.0 / static_cast<double>(k + 1);
+        cdf[k] = sum;
+      }
+      std::uniform_real_distribution<double> uniform(0.0, sum);
+      for (auto& value : values) {
+        const auto it = std::ranges::lower_bound(cdf, uniform(rng));
+        value = static_cast<int32_t>(it - cdf.begin());
+      }
+      break;
+    }
+    case Distribution::kNearlySorted:
+      for (size_t i = 0; i < n; ++i) values[i] = index(i);
+      for (size_t s = 0; n > 1 && s < swaps; ++s) {
+        std::swap(values[rng() % n], values[rng() % n]);
+      }
+      break;
+  }
+  return values;
+}
+
+struct Algorithm {
+  std::string_view name;
+  size_t max_size;  // skipped above this, e.g. quadratic sorts
+  std::function<void(std::span<int32_t>)> sort;
+  // Sorts instrumented keys; empty for sorts that do not compare.
+  std::function<void(std::span<Counted>)> counted_sort;
+};
+
+std::vector<Algorithm> algorithms() {
+  constexpr size_t kUnlimited = SIZE_MAX;
+  return {
+      {"bubble_sort", 10'000, [](auto arr) { bubble_sort(arr); },
+       [](auto arr) { bubble_sort(arr); }},
+      {"quick_sort", kUnlimited, [](auto arr) { quick_sort(arr); },
+       [](auto arr) { quick_sort(arr); }},
+      {"pdq_sort", kUnlimited, [](auto arr) { pdq_sort(arr); },
+       [](auto arr) { pdq_sort(arr); }},
+      {"parallel_sort", kUnlimited, [](auto arr) { parallel_sort(arr); },
+       [](auto arr) { parallel_sort(arr); }},
+      {"radix_sort", kUnlimited, [](auto arr) { radix_sort(arr); }, {}},
+      {"parallel_radix_sort", kUnlimited,
+       [](auto arr) { parallel_radix_sort(arr); }, {}},
+      {"std::sort", kUnlimited, [](auto arr) { std::ranges::sort(arr); },
+       [](auto arr) { std::ranges::sort(arr); }},
+      {"std::stable_sort", kUnlimited,
+       [](auto arr) { std::ranges::stable_sort(arr); },
+       [](auto arr) { std::ranges::stable_sort(arr); }},
+  };
+}
+
+struct Result {
+  size_t size;
+  Distribution distribution;
+  std::string_view algorithm;
+  double ns_per_element;
+  std::optional<uint64_t> comparisons;
+  std::optional<uint64_t> moves;
+};
+
+struct Options {
+  size_t min_size = 10;
+  size_t max_size = 1'000'000;
+  size_t swaps = 0;  // 0: sqrt(n)
+  std::string csv;
+  std::string json;
+};
+
+constexpr std::string_view kUsage =
+    "usage: sorting-benchmark [--min-size N] [--max-size N] [--swaps K]\n"
+    "                         [--csv FILE] [--json FILE]";
+
+// A non-negative integer option value. std::stoull alone would accept "-1"
+// or "12abc" and name only itself in its error.
+size_t parseCount(std::string_view option, const std::string& value) {
+  const bool digits =
+      !value.empty() && std::ranges::all_of(value, [](char c) {
+        return c >= '0' && c <= '9';
+      });
+  if (!digits) {
+    throw std::invalid_argument("Expected a number for " +
+                                std::string(option) + ", got '" + value +
+                                "'");
+  }
+  try {
+    return std::stoull(value);
+  } catch (const std::out_of_range&) {
+    throw std::out_of_range("Value for " + std::string(option) +
+                            " is too large: " + value);
+  }
+}
+
+// Throws std::invalid_argument or std::out_of_range for bad arguments.
+Options parseOptions(int argc, char* argv[]) {
+  Options options;
+  for (int i = 1; i < argc; ++i) {
+    const std::string_view arg = argv[i];
+    if (i + 1 >= argc) {
+      throw std::invalid_argument("Missing value for " + std::string(arg));
+    }
+    const std::string value = argv[++i];
+    if (arg == "--min-size") {
+      options.min_size = parseCount(arg, value);
+    } else if (arg == "--max-size") {
+      options.max_size = parseCount(arg, value);
+    } else if (arg == "--swaps") {
+      options.swaps = parseCount(arg, value);
+    } else if (arg == "--csv") {
+      options.csv = value;
+    } else if (arg == "--json") {
+      options.json = value;
+    } else {
+      throw std::invalid_argument("Unknown option " + std::string(arg));
+    }
+  }
+  // Sizes grow by multiplying, which never leaves 0.
+  if (options.min_size == 0) {
+    throw std::invalid_argument("--min-size must be at least 1");
+  }
+  return options;
+}
+
+// Repeats small sizes so every measurement covers at least this many
+// elements, unless that takes longer than kTimePerMeasurement, and keeps the
+// fastest repetition.
+constexpr size_t kElementsPerMeasurement = 1'000'000;
+constexpr std::chrono::milliseconds kTimePerMeasurement{500};
+// Operation counts need a second, slower pass; larger sizes skip it.
+constexpr size_t kMaxCountedSize = 1'000'000;
+
+Result measure(const Algorithm& algorithm, Distribution distribution,
+               const std::vector<int32_t>& input) {
+  const size_t n = input.size();
+  Result result{n, distribution, algorithm.name, 0, {}, {}};
+
+  const size_t repetitions =
+      std::max<size_t>(1, kElementsPerMeasurement / std::max<size_t>(n, 1));
+  double best = std::numeric_limits<double>::max();
+  std::vector<int32_t> values;
+  const auto deadline = std::chrono::steady_clock::now() + kTimePerMeasurement;
+  for (size_t r = 0; r < repetitions; ++r) {
+    values = input;
+    const auto start = std::chrono::steady_clock::now();
+    algorithm.sort(values);
+    const auto end = std::chrono::steady_clock::now();
+    best = std::min(best,
+                    std::chrono::duration<double, std::nano>(end - start)
+                        .count());
+    if (end > deadline) break;
+  }
+  if (!std::ranges::is_sorted(values)) {
+    throw std::logic_error(std::string(algorithm.name) + " did not sort " +
+                           std::string(name(distribution)));
+  }
+  result.ns_per_element = best / static_cast<double>(std::max<size_t>(n, 1));
+
+  if (algorithm.counted_sort && n <= kMaxCountedSize) {
+    std::vector<Counted> counted(input.begin(), input.end());
+    Counted::reset();
+    algorithm.counted_sort(counted);
+    result.comparisons = Counted::comparisons.load();
+    result.moves = Counted::moves.load();
+  }
+  return result;
+}
+
+std::string formatCount(const std::optional<uint64_t>& count) {
+  return count ? std::to_string(*count) : "";
+}
+
+void writeCsv(const std::string& path, const std::vector<Result>& results) {
+  std::ofstream out(path);
+  if (!out) throw std::runtime_error("Failed to open " + path);
+  out << "size,distribution,algorithm,ns_per_element,comparisons,moves\n";
+  for (const Result& r : results) {
+    out << std::format("{},{},{},{:.3f},{},{}\n", r.size, name(r.distribution),
+                       r.algorithm, r.ns_per_element,
+                       formatCount(r.comparisons), formatCount(r.moves));
+  }
+}
+
+void writeJson(const std::string& path, const std::vector<Result>& results) {
+  std::ofstream out(path);
+  if (!out) throw std::runtime_error("Failed to open " + path);
+  auto jsonCount = [](const std::optional<uint64_t>& count) {
+    return count ? std::to_string(*count) : std::string("null");
+  };
+  out << "[\n";
+  for (size_t i = 0; i < results.size(); ++i) {
+    const Result& r = results[i];
+    out << std::format(
+        "  {{\"size\": {}, \"distribution\": \"{}\", \"algorithm\": \"{}\", "
+        "\"ns_per_element\": {:.3f}, \"comparisons\": {}, \"moves\": {}}}{}\n",
+        r.size, name(r.distribution), r.algorithm, r.ns_per_element,
+        jsonCount(r.comparisons), jsonCount(r.moves),
+        i + 1 < results.size() ? "," : "");
+  }
+  out << "]\n";
+}
+
+int main(int argc, char* argv[]) {
+  Options options;
+  try {
+    options = parseOptions(argc, argv);
+  } catch (const std::logic_error& e) {
+    std::println(stderr, "{}\n{}", e.what(), kUsage);
+    return EXIT_FAILURE;
+  }
+  const std::vector<Algorithm> sorts = algorithms();
+  std::mt19937_64 rng(42);
+  std::vector<Result> results;
+
+  std::println("{:>10}  {:<14}{:<22}{:>10}{:>16}{:>16}", "size",
+               "distribution", "algorithm", "ns/elem", "comparisons",
+               "moves");
+  for (size_t n = options.min_size; n <= options.max_size; n *= 10) {
+    const size_t swaps = options.swaps > 0
+                             ? options.swaps
+                             : static_cast<size_t>(std::sqrt(
+                                   static_cast<double>(n)));
+    for (Distribution distribution : kDistributions) {
+      const std::vector<int32_t> input = generate(distribution, n, swaps, rng);
+      for (const Algorithm& algorithm : sorts) {
+        if (n > algorithm.max_size) continue;
+        const Result& r =
+            results.emplace_back(measure(algorithm, distribution, input));
+        std::println("{:>10}  {:<14}{:<22}{:>10.2f}{:>16}{:>16}", r.size,
+                     name(r.distribution), r.algorithm, r.ns_per_element,
+                     formatCount(r.comparisons), formatCount(r.moves));
+      }
+    }
+    if (n > options.max_size / 10) break;
+  }
+
+  if (!options.csv.empty()) writeCsv(options.csv, results);
+  if (!options.json.empty()) writeJson(options.json, results);
+  return EXIT_SUCCESS;
+}
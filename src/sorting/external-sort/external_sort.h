@@ -0,0 +1,319 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <future>
+#include <memory>
+#include <random>
+#include <span>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "pdq_sort.h"
+
+// Sorts a file of fixed-size records that does not fit in memory.
+//
+// 1. Run generation: read as many records as the memory budget allows, sort
+//    them with pdq_sort and spill them to a temporary run file. The next
+//    chunk is read in the background while the current one is sorted.
+// 2. Merge: a loser tree merges up to fan-in runs at once; with more runs
+//    than that, groups of runs are merged into longer runs first. Every run
+//    is read through two buffers: the merge consumes one while the next
+//    block is read into the other. The output is written the same way.
+//
+// Records are copied as raw bytes, so they must be trivially copyable; they
+// are ordered by operator<.
+struct ExternalSortOptions {
+  // Upper bound on the records held in memory at once, in bytes.
+  size_t memory_bytes = size_t{256} << 20;
+  // Size of each read or write buffer during the merge; shrunk when many
+  // runs have to share the memory budget.
+  size_t buffer_bytes = size_t{4} << 20;
+  std::filesystem::path temp_directory =
+      std::filesystem::temp_directory_path();
+};
+
+struct ExternalSortStats {
+  uint64_t bytes = 0;
+  size_t runs = 0;
+  size_t merge_passes = 0;
+  double run_seconds = 0;
+  double merge_seconds = 0;
+};
+
+namespace external_sort_detail {
+
+// Deletes the file when it goes out of scope.
+class TempFile {
+ public:
+  explicit TempFile(std::filesystem::path file) : path_(std::move(file)) {}
+  TempFile(const TempFile&) = delete;
+  TempFile& operator=(const TempFile&) = delete;
+  TempFile(TempFile&& other) noexcept
+      : path_(std::exchange(other.path_, {})) {}
+  TempFile& operator=(TempFile&&) = delete;
+  ~TempFile() {
+    std::error_code ignored;
+    if (!path_.empty()) std::filesystem::remove(path_, ignored);
+  }
+
+  [[nodiscard]] const std::filesystem::path& path() const { return path_; }
+
+ private:
+  std::filesystem::path path_;
+};
+
+// Fills buffer with up to count records; it ends up shorter only at the end
+// of the file.
+template <typename Record>
+void readRecords(std::ifstream& file, std::vector<Record>& buffer,
+                 size_t count) {
+  buffer.resize(count);
+  file.read(reinterpret_cast<char*>(buffer.data()),
+            static_cast<std::streamsize>(count * sizeof(Record)));
+  if (file.bad()) throw std::runtime_error("Failed to read records");
+  buffer.resize(static_cast<size_t>(file.gcount()) / sizeof(Record));
+}
+
+template <typename Record>
+void writeRecords(std::ofstream& file, std::span<const Record> records) {
+  file.write(reinterpret_cast<const char*>(records.data()),
+             static_cast<std::streamsize>(records.size_bytes()));
+  if (!file) throw std::runtime_error("Failed to write records");
+}
+
+// Sequential reader that always has the next block on its way.
+template <typename Record>
+class BlockReader {
+ public:
+  BlockReader(const std::filesystem::path& path, size_t records_per_block)
+      : file(path, std::ios::binary), block_size(records_per_block) {
+    if (!file) throw std::runtime_error("Failed to open " + path.string());
+    readRecords(file, blocks[0], block_size);
+    startRead();
+  }
+  BlockReader(const BlockReader&) = delete;
+  BlockReader& operator=(const BlockReader&) = delete;
+  ~BlockReader() {
+    if (pending.valid()) pending.wait();
+  }
+
+  [[nodiscard]] bool exhausted() const { return blocks[active].empty(); }
+  [[nodiscard]] const Record& head() const { return blocks[active][pos]; }
+
+  void advance() {
+    if (++pos < blocks[active].size()) return;
+    pending.get();
+    active ^= 1;
+    pos = 0;
+    if (!blocks[active].empty()) startRead();
+  }
+
+ private:
+  void startRead() {
+    pending = std::async(std::launch::async, [this, idle = active ^ 1] {
+      readRecords(file, blocks[idle], block_size);
+    });
+  }
+
+  std::ifstream file;
+  size_t block_size;
+  std::vector<Record> blocks[2];
+  size_t active = 0;
+  size_t pos = 0;
+  std::future<void> pending;
+};
+
+// Sequential writer that fills one block while the other is being written.
+template <typename Record>
+class BlockWriter {
+ public:
+  BlockWriter(const std::filesystem::path& path, size_t records_per_block)
+      : file(path, std::ios::binary | std::ios::trunc),
+        block_size(records_per_block) {
+    if (!file) throw std::runtime_error("Failed to create " + path.string());
+    blocks[0].reserve(block_size);
+    blocks[1].reserve(block_size);
+  }
+  BlockWriter(const BlockWriter&) = delete;
+  BlockWriter& operator=(const BlockWriter&) = delete;
+  ~BlockWriter() {
+    if (pending.valid()) pending.wait();
+  }
+
+  void push(const Record& record) {
+    blocks[active].push_back(record);
+    if (blocks[active].size() == block_size) flush();
+  }
+
+  // Writes what is left and surfaces any write error.
+  void finish() {
+    flush();
+    if (pending.valid()) pending.get();
+    file.close();
+    if (!file) throw std::runtime_error("Failed to close output");
+  }
+
+ private:
+  void flush() {
+    if (pending.valid()) pending.get();
+    pending = std::async(std::launch::async, [this, full = active] {
+      writeRecords<Record>(file, blocks[full]);
+      blocks[full].clear();
+    });
+    active ^= 1;
+  }
+
+  std::ofstream file;
+  size_t block_size;
+  std::vector<Record> blocks[2];
+  size_t active = 0;
+  std::future<void> pending;
+};
+
+// Merges sorted run files into output with a tree of losers, as KWayMerge
+// in the heap examples does for in-memory runs.
+template <typename Record>
+void mergeRuns(std::span<const TempFile> runs,
+               const std::filesystem::path& output, size_t block_records) {
+  const size_t k = runs.size();
+  std::vector<std::unique_ptr<BlockReader<Record>>> readers;
+  readers.reserve(k);
+  for (const TempFile& run : runs) {
+    readers.push_back(
+        std::make_unique<BlockReader<Record>>(run.path(), block_records));
+  }
+  BlockWriter<Record> writer(output, block_records);
+
+  // Exhausted runs lose every match; ties go to the lower run index.
+  auto beats = [&](size_t a, size_t b) {
+    if (readers[a]->exhausted()) return false;
+    if (readers[b]->exhausted()) return true;
+    if (readers[a]->head() < readers[b]->head()) return true;
+    if (readers[b]->head() < readers[a]->head()) return false;
+    return a < b;
+  };
+
+  std::vector<size_t> losers(k, 0);
+  std::vector<size_t> winners(2 * k);
+  for (size_t run = 0; run < k; ++run) winners[k + run] = run;
+  for (size_t node = k - 1; node > 0; --node) {
+    const size_t a = winners[2 * node];
+    const size_t b = winners[2 * node + 1];
+    const bool a_wins = beats(a, b);
+    winners[node] = a_wins ? a : b;
+    losers[node] = a_wins ? b : a;
+  }
+  size_t winner = k == 1 ? 0 : winners[1];
+
+  while (!readers[winner]->exhausted()) {
+    writer.push(readers[winner]->head());
+    readers[winner]->advance();
+    for (size_t node = (winner + k) / 2; node > 0; node /= 2) {
+      if (beats(losers[node], winner)) std::swap(losers[node], winner);
+    }
+  }
+  writer.finish();
+}
+
+}  // namespace external_sort_detail
+
+template <Sortable Record>
+  requires std::is_trivially_copyable_v<Record>
+ExternalSortStats external_sort(const std::filesystem::path& input,
+                                const std::filesystem::path& output,
+                                const ExternalSortOptions& options = {}) {
+  using namespace external_sort_detail;
+  using Clock = std::chrono::steady_clock;
+
+  ExternalSortStats stats;
+  stats.bytes = std::filesystem::file_size(input);
+  if (stats.bytes % sizeof(Record) != 0) {
+    throw std::invalid_argument("Input size is not a multiple of the record");
+  }
+  // Two chunks are in memory during run generation: one being sorted and one
+  // being read.
+  const size_t chunk_records =
+      std::max<size_t>(1, options.memory_bytes / 2 / sizeof(Record));
+
+  std::ifstream in(input, std::ios::binary);
+  if (!in) throw std::runtime_error("Failed to open " + input.string());
+
+  std::mt19937_64 rng(std::random_device{}());
+  const std::string prefix = std::format("external-sort-{:016x}", rng());
+  size_t run_id = 0;
+  auto newRun = [&] {
+    return TempFile(options.temp_directory /
+                    std::format("{}-{}.run", prefix, run_id++));
+  };
+
+  // Run generation. Input that fits in one chunk goes straight to the
+  // output.
+  auto start = Clock::now();
+  std::vector<TempFile> runs;
+  std::vector<Record> current;
+  std::vector<Record> next;
+  readRecords(in, current, chunk_records);
+  if (in.peek() == std::ifstream::traits_type::eof()) {
+    pdq_sort(std::span<Record>(current));
+    std::ofstream out(output, std::ios::binary | std::ios::trunc);
+    writeRecords<Record>(out, current);
+    stats.runs = 1;
+    stats.run_seconds =
+        std::chrono::duration<double>(Clock::now() - start).count();
+    return stats;
+  }
+  while (!current.empty()) {
+    auto reading = std::async(std::launch::async, [&] {
+      readRecords(in, next, chunk_records);
+    });
+    pdq_sort(std::span<Record>(current));
+    std::ofstream out(runs.emplace_back(newRun()).path(),
+                      std::ios::binary | std::ios::trunc);
+    writeRecords<Record>(out, current);
+    reading.get();
+    std::swap(current, next);
+  }
+  stats.runs = runs.size();
+  stats.run_seconds =
+      std::chrono::duration<double>(Clock::now() - start).count();
+
+  // Each open run needs two blocks, and so does the output.
+  start = Clock::now();
+  auto blockRecords = [&](size_t streams) {
+    const size_t share = options.memory_bytes / (2 * (streams + 1));
+    return std::max<size_t>(
+        1, std::min(options.buffer_bytes, share) / sizeof(Record));
+  };
+  const size_t min_block = std::max<size_t>(sizeof(Record), 64 << 10);
+  const size_t fan_in =
+      std::max<size_t>(3, options.memory_bytes / (2 * min_block)) - 1;
+
+  while (runs.size() > fan_in) {
+    std::vector<TempFile> merged;
+    for (size_t first = 0; first < runs.size(); first += fan_in) {
+      const size_t count = std::min(fan_in, runs.size() - first);
+      if (count == 1) {
+        merged.push_back(std::move(runs[first]));
+        continue;
+      }
+      merged.push_back(newRun());
+      mergeRuns<Record>(std::span(runs).subspan(first, count),
+                        merged.back().path(), blockRecords(count));
+    }
+    runs = std::move(merged);
+    ++stats.merge_passes;
+  }
+  mergeRuns<Record>(runs, output, blockRecords(runs.size()));
+  ++stats.merge_passes;
+  stats.merge_seconds =
+      std::chrono::duration<double>(Clock::now() - start).count();
+  return stats;
+}
@@ -0,0 +1,107 @@
+#include <array>
+#include <compare>
+#include <cstdint>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <print>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "external_sort.h"
+
+// A 64-byte record ordered by its key, like a row in a table dump.
+struct Record {
+  uint64_t key;
+  std::array<char, 56> payload;
+
+  friend bool operator==(const Record& a, const Record& b) {
+    return a.key == b.key;
+  }
+  friend std::weak_ordering operator<=>(const Record& a, const Record& b) {
+    return a.key <=> b.key;
+  }
+};
+
+void generateInput(const std::filesystem::path& path, uint64_t bytes) {
+  std::mt19937_64 rng(42);
+  std::ofstream out(path, std::ios::binary | std::ios::trunc);
+  std::vector<Record> block(1 << 16);
+  for (uint64_t written = 0; written < bytes;) {
+    const size_t count = static_cast<size_t>(std::min<uint64_t>(
+        block.size(), (bytes - written) / sizeof(Record)));
+    if (count == 0) break;
+    for (size_t i = 0; i < count; ++i) {
+      block[i].key = rng();
+      block[i].payload.fill(static_cast<char>('a' + block[i].key % 26));
+    }
+    out.write(reinterpret_cast<const char*>(block.data()),
+              static_cast<std::streamsize>(count * sizeof(Record)));
+    written += count * sizeof(Record);
+  }
+}
+
+// Streams through the output checking order and the record count.
+bool verifySorted(const std::filesystem::path& path, uint64_t bytes) {
+  std::ifstream in(path, std::ios::binary);
+  std::vector<Record> block(1 << 16);
+  uint64_t seen = 0;
+  uint64_t previous = 0;
+  while (in) {
+    in.read(reinterpret_cast<char*>(block.data()),
+            static_cast<std::streamsize>(block.size() * sizeof(Record)));
+    const size_t count = static_cast<size_t>(in.gcount()) / sizeof(Record);
+    for (size_t i = 0; i < count; ++i) {
+      if (block[i].key < previous) return false;
+      previous = block[i].key;
+    }
+    seen += count * sizeof(Record);
+  }
+  return seen == bytes;
+}
+
+void benchmarkExternalSort(uint64_t bytes, size_t memory_bytes) {
+  const auto directory = std::filesystem::temp_directory_path();
+  const auto input = directory / "external-sort-input.bin";
+  const auto output = directory / "external-sort-output.bin";
+  generateInput(input, bytes);
+
+  ExternalSortOptions options;
+  options.memory_bytes = memory_bytes;
+  const ExternalSortStats stats = external_sort<Record>(input, output, options);
+
+  constexpr double kMiB = 1 << 20;
+  constexpr double kMB = 1e6;
+  const double mib = static_cast<double>(stats.bytes) / kMiB;
+  const double mb = static_cast<double>(stats.bytes) / kMB;
+  const double total = stats.run_seconds + stats.merge_seconds;
+  std::println("Sorted {:.0f} MiB with {:.0f} MiB of memory: {} runs, {} merge "
+               "pass(es), output {}",
+               mib, static_cast<double>(memory_bytes) / kMiB, stats.runs,
+               stats.merge_passes,
+               verifySorted(output, stats.bytes) ? "sorted" : "NOT SORTED");
+  std::println("  run generation {:>8.2f} s {:>8.1f} MB/s", stats.run_seconds,
+               mb / stats.run_seconds);
+  if (stats.merge_passes > 0) {
+    std::println("  merge          {:>8.2f} s {:>8.1f} MB/s",
+                 stats.merge_seconds, mb / stats.merge_seconds);
+  }
+  std::println("  total          {:>8.2f} s {:>8.1f} MB/s", total,
+               mb / total);
+
+  std::filesystem::remove(input);
+  std::filesystem::remove(output);
+}
+
+int main(int argc, char* argv[]) {
+  // Input size and memory budget in MiB can be given on the command line.
+  const uint64_t input_mib = argc > 1 ? std::stoull(argv[1]) : 1024;
+  const size_t memory_mib = argc > 2 ? std::stoul(argv[2]) : 128;
+  benchmarkExternalSort(input_mib << 20, memory_mib << 20);
+
+  // A tiny budget forces more runs than one merge can take at once.
+  benchmarkExternalSort(64 << 20, 1 << 20);
+
+  return EXIT_SUCCESS;
+}
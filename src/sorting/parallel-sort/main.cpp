@@ -0,0 +1,70 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <execution>
+#include <print>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "parallel_sort.h"
+
+template <typename Sort>
+double timeSort(const std::vector<int>& input, Sort sort) {
+  std::vector<int> values = input;
+  auto start = std::chrono::high_resolution_clock::now();
+  sort(values);
+  auto end = std::chrono::high_resolution_clock::now();
+  if (!std::ranges::is_sorted(values)) std::println("NOT SORTED");
+  return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+// Reports the speedup of parallel_sort over the single-threaded pdq_sort it
+// is built on, and compares it with the standard parallel algorithm.
+void benchmarkParallelSort(size_t size) {
+  std::mt19937 rng(42);
+  std::uniform_int_distribution<int> any;
+  std::vector<int> input(size);
+  for (auto& value : input) value = any(rng);
+
+  const size_t hardware = std::max(1u, std::thread::hardware_concurrency());
+  std::println("Sorting {} random ints with up to {} threads (ms)", size,
+               hardware);
+
+  const double baseline = timeSort(input, [](auto& v) { pdq_sort(v); });
+  std::println("{:<32}{:>10.1f}", "pdq_sort", baseline);
+
+  for (size_t threads = 2; threads <= hardware; threads *= 2) {
+    const double elapsed =
+        timeSort(input, [=](auto& v) { parallel_sort(v, threads); });
+    std::println("{:<32}{:>10.1f}  speedup {:.2f}x",
+                 "parallel_sort, " + std::to_string(threads) + " threads",
+                 elapsed, baseline / elapsed);
+  }
+  const double all = timeSort(input, [](auto& v) { parallel_sort(v); });
+  std::println("{:<32}{:>10.1f}  speedup {:.2f}x", "parallel_sort, all threads",
+               all, baseline / all);
+
+  const double sequential =
+      timeSort(input, [](auto& v) { std::sort(v.begin(), v.end()); });
+  std::println("{:<32}{:>10.1f}", "std::sort", sequential);
+  const double par = timeSort(input, [](auto& v) {
+    std::sort(std::execution::par, v.begin(), v.end());
+  });
+  std::println("{:<32}{:>10.1f}", "std::sort(std::execution::par)", par);
+}
+
+int main(int argc, char* argv[]) {
+  std::vector<int> arr = {3, 6, 8, 10, 1, 2, 1};
+  parallel_sort(arr);
+  std::print("Sorted array: ");
+  for (int value : arr) std::print("{} ", value);
+  std::println("");
+
+  // The element count can be given on the command line.
+  const size_t size = argc > 1 ? std::stoul(argv[1]) : 100'000'000;
+  benchmarkParallelSort(size);
+
+  return EXIT_SUCCESS;
+}
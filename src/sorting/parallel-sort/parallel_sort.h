@@ -0,0 +1,139 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <ranges>
+#include <span>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "pdq_sort.h"
+
+// Parallel sample sort. A sorted sample of the input picks splitters that cut
+// the key space into buckets of roughly equal size. Each thread classifies
+// one contiguous chunk into per-bucket vectors; then each bucket is gathered
+// back into its final place in the array and sorted with pdq_sort, buckets
+// being handed out to threads from a shared counter. Both phases touch every
+// element once and run fully in parallel, unlike a parallel quicksort whose
+// first partition is sequential.
+//
+// Every splitter also gets an "equal" bucket of its own. A heavily repeated
+// key is likely to be sampled, lands in that bucket, and is copied rather
+// than sorted, so duplicates cannot pile up into one oversized bucket.
+namespace parallel_sort_detail {
+
+// Below this many elements per thread, threads cost more than they save.
+inline constexpr size_t kMinElementsPerThread = 1 << 16;
+// Buckets per thread; more buckets balance uneven ones better.
+inline constexpr size_t kBucketsPerThread = 8;
+// Sample elements per splitter.
+inline constexpr size_t kOversampling = 16;
+
+template <typename T>
+std::vector<T> chooseSplitters(std::span<const T> arr, size_t count) {
+  const size_t sample_size = count * kOversampling;
+  std::vector<T> sample;
+  sample.reserve(sample_size);
+  // Evenly spaced positions, offset to avoid always sampling the ends.
+  const size_t stride = arr.size() / sample_size;
+  for (size_t i = 0; i < sample_size; ++i) {
+    sample.push_back(arr[i * stride + stride / 2]);
+  }
+  pdq_sort(sample);
+
+  std::vector<T> splitters;
+  splitters.reserve(count);
+  for (size_t i = 1; i <= count; ++i) {
+    const T& candidate = sample[i * kOversampling - kOversampling / 2];
+    if (splitters.empty() || splitters.back() < candidate) {
+      splitters.push_back(candidate);
+    }
+  }
+  return splitters;
+}
+
+// Buckets alternate between the open interval before splitter k (index 2k)
+// and the elements equal to it (index 2k + 1); the last bucket holds
+// everything above the largest splitter.
+template <typename T>
+size_t bucketOf(const T& value, const std::vector<T>& splitters) {
+  const auto it = std::ranges::lower_bound(splitters, value);
+  const size_t k = static_cast<size_t>(it - splitters.begin());
+  const bool equal = it != splitters.end() && !(value < *it);
+  return 2 * k + (equal ? 1 : 0);
+}
+
+}  // namespace parallel_sort_detail
+
+// Sorts arr using up to `threads` threads; 0 means one per hardware thread.
+template <Sortable T>
+void parallel_sort(std::span<T> arr, size_t threads = 0) {
+  using namespace parallel_sort_detail;
+
+  if (threads == 0) {
+    threads = std::max(1u, std::thread::hardware_concurrency());
+  }
+  threads = std::min(threads, arr.size() / kMinElementsPerThread);
+  if (threads <= 1) {
+    pdq_sort(arr);
+    return;
+  }
+
+  const std::vector<T> splitters = chooseSplitters<T>(
+      std::span<const T>(arr), threads * kBucketsPerThread - 1);
+  const size_t bucket_count = 2 * splitters.size() + 1;
+
+  // Phase 1: thread t moves its chunk into buckets[t][b].
+  std::vector<std::vector<std::vector<T>>> buckets(
+      threads, std::vector<std::vector<T>>(bucket_count));
+  {
+    std::vector<std::jthread> workers;
+    for (size_t t = 0; t < threads; ++t) {
+      workers.emplace_back([&, t] {
+        const size_t begin = arr.size() * t / threads;
+        const size_t end = arr.size() * (t + 1) / threads;
+        auto& local = buckets[t];
+        for (size_t i = begin; i < end; ++i) {
+          local[bucketOf(arr[i], splitters)].push_back(std::move(arr[i]));
+        }
+      });
+    }
+  }
+
+  // Bucket b starts after every element of the buckets before it.
+  std::vector<size_t> offsets(bucket_count + 1, 0);
+  for (size_t b = 0; b < bucket_count; ++b) {
+    offsets[b + 1] = offsets[b];
+    for (size_t t = 0; t < threads; ++t) {
+      offsets[b + 1] += buckets[t][b].size();
+    }
+  }
+
+  // Phase 2: gather each bucket into place and sort it. Equal buckets are
+  // already sorted.
+  std::atomic<size_t> next_bucket{0};
+  std::vector<std::jthread> workers;
+  for (size_t t = 0; t < threads; ++t) {
+    workers.emplace_back([&] {
+      for (size_t b = next_bucket++; b < bucket_count; b = next_bucket++) {
+        size_t pos = offsets[b];
+        for (size_t source = 0; source < threads; ++source) {
+          auto& bucket = buckets[source][b];
+          std::ranges::move(bucket, arr.subspan(pos).begin());
+          pos += bucket.size();
+          std::vector<T>().swap(bucket);
+        }
+        if (b % 2 == 0) {
+          pdq_sort(arr.subspan(offsets[b], offsets[b + 1] - offsets[b]));
+        }
+      }
+    });
+  }
+}
+
+template <SortableRange Range>
+void parallel_sort(Range&& range, size_t threads = 0) {
+  parallel_sort(std::span{std::forward<Range>(range)}, threads);
+}
@@ -1,81 +1,166 @@
-#include <concepts>
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <compare>
+#include <cstdint>
 #include <cstdlib>
 #include <print>
+#include <random>
 #include <ranges>
-#include <stdexcept>
-#include <utility>
-
-template <typename T>
-concept Sortable = std::totally_ordered<T> && std::movable<T>;
-
-template <typename T>
-[[nodiscard]] constexpr T medianOfThreePivot(std::span<T> arr) {
-  if (arr.size() < 2) {
-    throw std::invalid_argument("span size must be at least 2");
-  }
-
-  size_t low = 0;
-  size_t high = arr.size() - 1;
-  size_t mid = high / 2;
-
-  // Sort the three elements at low, mid, and high
-  if (arr[mid] < arr[low]) std::swap(arr[mid], arr[low]);
-  if (arr[high] < arr[low]) std::swap(arr[high], arr[low]);
-  if (arr[high] < arr[mid]) std::swap(arr[high], arr[mid]);
-
-  // Place the median just before the last element as the pivot
-  std::swap(arr[mid], arr[high - 1]);
-
-  return arr[high - 1];  // Return the pivot value
-}
-
-template <Sortable T>
-[[nodiscard]] constexpr size_t partition(std::span<T> arr) {
-  if (arr.size() <= 2) return 0;
-
-  T pivot = medianOfThreePivot(arr);
-  size_t low = 0;
-  size_t high = arr.size() - 1;
-
-  size_t i = low;
-  size_t j = high - 1;
+#include <vector>
+
+#include "pdq_sort.h"
+#include "quick_sort.h"
+#include "small_sort.h"
+
+// McIlroy's "killer adversary": items start as undecided "gas" and are frozen
+// to the next smallest value only when a comparison forces it, always keeping
+// the current pivot candidate as gas. Replaying the frozen values against the
+// same partition makes every split as lopsided as possible, which takes a
+// plain median-of-three quicksort to O(n²). Introsort notices the recursion
+// getting too deep and finishes those spans with heapsort.
+class Adversary {
+ public:
+  explicit Adversary(size_t n) : values(n, n - 1), gas(n - 1) {}
+
+  struct Item {
+    size_t index;
+    Adversary* owner;
+
+    friend bool operator==(const Item& a, const Item& b) {
+      return a.owner->compare(a.index, b.index) == 0;
+    }
+    friend std::weak_ordering operator<=>(const Item& a, const Item& b) {
+      return a.owner->compare(a.index, b.index) <=> 0;
+    }
+  };
 
-  while (true) {
-    while (arr[i] < pivot) i++;
-    while (pivot < arr[j]) j--;
-    if (i >= j) break;
-    std::swap(arr[i], arr[j]);
-    i++;
-    j--;
+  // Runs quick_sort over indices and returns the values the adversary chose.
+  std::vector<size_t> generate() {
+    std::vector<Item> items;
+    for (size_t i = 0; i < values.size(); ++i) items.push_back({i, this});
+    quick_sort(items);
+    return values;
   }
 
-  // Ensuring pivot is at its correct position
-  if (i < high) {
-    std::swap(arr[i], arr[high - 1]);
+  // Three-way comparison that decides gas items on demand.
+  int compare(size_t x, size_t y) {
+    if (values[x] == gas && values[y] == gas) {
+      values[x == candidate ? x : y] = solid++;
+    }
+    if (values[x] == gas) {
+      candidate = x;
+    } else if (values[y] == gas) {
+      candidate = y;
+    }
+    return (values[x] > values[y]) - (values[x] < values[y]);
   }
 
-  return i;
+ private:
+  std::vector<size_t> values;
+  size_t gas;
+  size_t solid = 0;
+  size_t candidate = 0;
+};
+
+void benchmarkAdversarial() {
+  constexpr size_t kSize = 1'000'000;
+  auto values = Adversary(kSize).generate();
+
+  auto start = std::chrono::high_resolution_clock::now();
+  quick_sort(values);
+  auto end = std::chrono::high_resolution_clock::now();
+  std::chrono::duration<double, std::milli> elapsed = end - start;
+
+  std::println("Adversarial input of {} elements sorted in {:.1f} ms ({})",
+               kSize, elapsed.count(),
+               std::ranges::is_sorted(values) ? "ok" : "NOT SORTED");
 }
 
-template <typename Range>
-concept SortableRange = std::ranges::random_access_range<Range> &&
-                        Sortable<std::ranges::range_value_t<Range>>;
-
-template <SortableRange Range>
-constexpr void quick_sort(Range&& range) {
-  quick_sort(std::span{std::forward<Range>(range)});
+template <typename Sort>
+double timeSort(std::vector<int> values, Sort sort) {
+  auto start = std::chrono::high_resolution_clock::now();
+  sort(values);
+  auto end = std::chrono::high_resolution_clock::now();
+  if (!std::ranges::is_sorted(values)) std::println("NOT SORTED");
+  return std::chrono::duration<double, std::milli>(end - start).count();
 }
 
-template <Sortable T>
-constexpr void quick_sort(std::span<T> arr) noexcept {
-  if (arr.size() < 2) return;
+// Presorted and low-cardinality keys are where pdq_sort's pattern detection
+// and equal-element partitioning pay off; random keys show the effect of the
+// branchless block partition.
+void benchmarkPatterns() {
+  constexpr size_t kSize = 2'000'000;
+  std::mt19937 rng(42);
+  std::uniform_int_distribution<int> any;
+
+  auto generate = [&](auto element) {
+    std::vector<int> values(kSize);
+    for (size_t i = 0; i < kSize; ++i) values[i] = element(i);
+    return values;
+  };
+  const std::vector<std::pair<const char*, std::vector<int>>> inputs = {
+      {"random", generate([&](size_t) { return any(rng); })},
+      {"sorted", generate([](size_t i) { return static_cast<int>(i); })},
+      {"reversed",
+       generate([](size_t i) { return static_cast<int>(kSize - i); })},
+      {"sorted + 1% noise", generate([&](size_t i) {
+         return rng() % 100 == 0 ? any(rng) : static_cast<int>(i);
+       })},
+      {"16 distinct keys",
+       generate([&](size_t) { return static_cast<int>(rng() % 16); })},
+      {"organ pipe", generate([](size_t i) {
+         return static_cast<int>(i < kSize / 2 ? i : kSize - i);
+       })},
+  };
 
-  size_t p = partition(arr);
+  std::println("\nSorting {} ints (ms)", kSize);
+  std::println("{:<20}{:>12}{:>12}{:>12}", "input", "quick_sort", "pdq_sort",
+               "std::sort");
+  for (const auto& [name, values] : inputs) {
+    const double quick = timeSort(values, [](auto& v) { quick_sort(v); });
+    const double pdq = timeSort(values, [](auto& v) { pdq_sort(v); });
+    const double standard =
+        timeSort(values, [](auto& v) { std::ranges::sort(v); });
+    std::println("{:<20}{:>12.1f}{:>12.1f}{:>12.1f}", name, quick, pdq,
+                 standard);
+  }
+}
 
-  if (p > 0) {
-    quick_sort(arr.subspan(0, p));
+// Many tiny sorts back to back, as in per-request work: small_sort's networks
+// against insertion sort and std::sort.
+void benchmarkSmallSorts() {
+  constexpr size_t kElements = 4'000'000;
+  std::mt19937 rng(7);
+  std::vector<int32_t> input(kElements);
+  for (auto& value : input) value = static_cast<int32_t>(rng());
+
+  std::println("\nSorting {} ints in arrays of n (ns/element){}", kElements,
+               kHasSimdSmallSort ? "" : ", small_sort without AVX2");
+  std::println("{:<6}{:>12}{:>16}{:>12}", "n", "small_sort", "insertion_sort",
+               "std::sort");
+  for (size_t n : std::to_array<size_t>({8, 16, 24, 32, 48, 64})) {
+    auto perElement = [&](auto sort) {
+      std::vector<int32_t> values = input;
+      const size_t arrays = kElements / n;
+      auto start = std::chrono::high_resolution_clock::now();
+      for (size_t i = 0; i < arrays; ++i) {
+        sort(std::span<int32_t>(values).subspan(i * n, n));
+      }
+      auto end = std::chrono::high_resolution_clock::now();
+      return std::chrono::duration<double, std::nano>(end - start).count() /
+             static_cast<double>(arrays * n);
+    };
+    const double network =
+        perElement([](std::span<int32_t> arr) { small_sort(arr); });
+    const double insertion =
+        perElement([](std::span<int32_t> arr) { insertion_sort(arr); });
+    const double standard =
+        perElement([](std::span<int32_t> arr) { std::ranges::sort(arr); });
+    std::println("{:<6}{:>12.2f}{:>16.2f}{:>12.2f}", n, network, insertion,
+                 standard);
   }
-  quick_sort(arr.subspan(p + 1));
 }
 
 int main() {
@@ -96,5 +181,23 @@ int main() {
   std::println("Sorted array: ");
   print_array(arr);
 
+  // The networks must only reorder: -0.0 and +0.0 compare equal, yet each
+  // must come out as many times as it went in.
+  std::vector<float> zeros(1000);
+  std::mt19937 rng(7);
+  for (auto& zero : zeros) zero = rng() % 2 == 0 ? -0.0F : 0.0F;
+  const auto negative = [](const std::vector<float>& values) {
+    return std::ranges::count_if(values,
+                                 [](float v) { return std::signbit(v); });
+  };
+  const auto before = negative(zeros);
+  quick_sort<float>(zeros);
+  std::println("Negative zeros before and after sorting: {} and {}", before,
+               negative(zeros));
+
+  benchmarkAdversarial();
+  benchmarkPatterns();
+  benchmarkSmallSorts();
+
   return EXIT_SUCCESS;
-}
\ No newline at end of file
+}
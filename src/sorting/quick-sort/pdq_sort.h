@@ -0,0 +1,398 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <span>
+#include <type_traits>
+#include <utility>
+
+#include "quick_sort.h"
+
+// Pattern-defeating quicksort (Orson Peters' pdqsort). It keeps introsort's
+// O(n log n) guarantee but adapts to the inputs that hurt a plain quicksort:
+//
+//  - Partitions that find nothing to swap are followed by a bounded insertion
+//    sort, so sorted and nearly sorted spans finish in O(n). A span that is
+//    entirely sorted or strictly descending is recognised up front.
+//  - A badly unbalanced partition swaps a few elements around the ends of
+//    both halves to break up whatever pattern produced it; only after
+//    log2(n) bad partitions does it give up and heapsort.
+//  - When the pivot equals the element just before the span (the previous
+//    pivot), the span holds nothing smaller, so it splits off every element
+//    equal to the pivot and never touches them again. Many duplicates are
+//    therefore sorted in O(n log k) for k distinct keys.
+//  - For arithmetic types, partitioning follows BlockQuicksort: it records
+//    the offsets of misplaced elements for a block of 64 with branch-free
+//    code and swaps them in a second pass, so the comparison result never
+//    feeds a branch the CPU has to predict.
+namespace pdq_detail {
+
+inline constexpr size_t kInsertionSortThreshold = 24;
+inline constexpr size_t kNintherThreshold = 128;
+inline constexpr size_t kPartialInsertionSortLimit = 8;
+inline constexpr size_t kBlockSize = 64;
+
+// Insertion sort for a range that is not the leftmost one, so *(begin - 1)
+// exists and is not greater than any element: the inner loop needs no bound.
+template <typename T>
+void unguardedInsertionSort(T* begin, T* end) {
+  if (begin == end) return;
+  for (T* cur = begin + 1; cur != end; ++cur) {
+    if (!(*cur < *(cur - 1))) continue;
+    T value = std::move(*cur);
+    T* hole = cur;
+    do {
+      *hole = std::move(*(hole - 1));
+      --hole;
+    } while (value < *(hole - 1));
+    *hole = std::move(value);
+  }
+}
+
+// Insertion sort that gives up, leaving the range a valid permutation, once
+// it has moved more than kPartialInsertionSortLimit elements. Returns whether
+// the range ended up sorted.
+template <typename T>
+bool partialInsertionSort(T* begin, T* end) {
+  if (begin == end) return true;
+  size_t moved = 0;
+  for (T* cur = begin + 1; cur != end; ++cur) {
+    if (!(*cur < *(cur - 1))) continue;
+    T value = std::move(*cur);
+    T* hole = cur;
+    do {
+      *hole = std::move(*(hole - 1));
+      --hole;
+    } while (hole != begin && value < *(hole - 1));
+    *hole = std::move(value);
+    moved += static_cast<size_t>(cur - hole);
+    if (moved > kPartialInsertionSortLimit) return false;
+  }
+  return true;
+}
+
+template <typename T>
+void sort2(T* a, T* b) {
+  if (*b < *a) std::swap(*a, *b);
+}
+
+template <typename T>
+void sort3(T* a, T* b, T* c) {
+  sort2(a, b);
+  sort2(b, c);
+  sort2(a, b);
+}
+
+// Moves the median of three (or, for large ranges, Tukey's ninther) to
+// *begin, where the partitions expect the pivot.
+template <typename T>
+void choosePivot(T* begin, T* end) {
+  const size_t size = static_cast<size_t>(end - begin);
+  const size_t half = size / 2;
+  if (size > kNintherThreshold) {
+    sort3(begin, begin + half, end - 1);
+    sort3(begin + 1, begin + (half - 1), end - 2);
+    sort3(begin + 2, begin + (half + 1), end - 3);
+    sort3(begin + (half - 1), begin + half, begin + (half + 1));
+    std::swap(*begin, *(begin + half));
+  } else {
+    sort3(begin + half, begin, end - 1);
+  }
+}
+
+template <typename T>
+struct PartitionResult {
+  T* pivot;
+  bool already_partitioned;  // no element had to move
+};
+
+// Swaps the elements at first + offsets_l[i] and last - offsets_r[i]. When
+// the counts differ, a cyclic permutation does the same job with one move per
+// element instead of three.
+template <typename T>
+void swapOffsets(T* first, T* last, const unsigned char* offsets_l,
+                 const unsigned char* offsets_r, size_t count,
+                 bool use_swaps) {
+  if (use_swaps) {
+    for (size_t i = 0; i < count; ++i) {
+      std::swap(*(first + offsets_l[i]), *(last - offsets_r[i]));
+    }
+  } else if (count > 0) {
+    T* left = first + offsets_l[0];
+    T* right = last - offsets_r[0];
+    T value = std::move(*left);
+    *left = std::move(*right);
+    for (size_t i = 1; i < count; ++i) {
+      left = first + offsets_l[i];
+      *right = std::move(*left);
+      right = last - offsets_r[i];
+      *left = std::move(*right);
+    }
+    *right = std::move(value);
+  }
+}
+
+// Partitions [begin, end) around *begin into elements < pivot, the pivot, and
+// elements >= pivot, and returns the pivot's final position. choosePivot
+// leaves an element >= pivot at the end, which bounds the left scan.
+template <typename T>
+PartitionResult<T> partitionRight(T* begin, T* end) {
+  T pivot = std::move(*begin);
+  T* first = begin;
+  T* last = end;
+
+  while (*++first < pivot) {
+  }
+  // Without an element before first, nothing stops the right scan.
+  if (first - 1 == begin) {
+    while (first < last && !(*--last < pivot)) {
+    }
+  } else {
+    while (!(*--last < pivot)) {
+    }
+  }
+
+  const bool already_partitioned = first >= last;
+  while (first < last) {
+    std::swap(*first, *last);
+    while (*++first < pivot) {
+    }
+    while (!(*--last < pivot)) {
+    }
+  }
+
+  T* pivot_pos = first - 1;
+  *begin = std::move(*pivot_pos);
+  *pivot_pos = std::move(pivot);
+  return {pivot_pos, already_partitioned};
+}
+
+// Same contract as partitionRight, with BlockQuicksort's branch-free scans.
+template <typename T>
+PartitionResult<T> partitionRightBranchless(T* begin, T* end) {
+  T pivot = std::move(*begin);
+  T* first = begin;
+  T* last = end;
+
+  while (*++first < pivot) {
+  }
+  if (first - 1 == begin) {
+    while (first < last && !(*--last < pivot)) {
+    }
+  } else {
+    while (!(*--last < pivot)) {
+    }
+  }
+
+  const bool already_partitioned = first >= last;
+  if (!already_partitioned) {
+    std::swap(*first, *last);
+    ++first;
+
+    // Offsets of misplaced elements: from left_base for the left block, and
+    // back from right_base for the right one.
+    alignas(64) unsigned char offsets_l[kBlockSize];
+    alignas(64) unsigned char offsets_r[kBlockSize];
+    T* left_base = first;
+    T* right_base = last;
+    size_t num_l = 0;
+    size_t num_r = 0;
+    size_t start_l = 0;
+    size_t start_r = 0;
+
+    while (first < last) {
+      // Refill whichever blocks are empty; when both are, split the unknown
+      // elements between them.
+      const size_t unknown = static_cast<size_t>(last - first);
+      size_t left_split = 0;
+      if (num_l == 0) left_split = num_r == 0 ? unknown / 2 : unknown;
+      const size_t right_split = num_r == 0 ? unknown - left_split : 0;
+
+      // Every offset is written, but the count only advances past those
+      // whose element is on the wrong side.
+      const size_t left_count = std::min(left_split, kBlockSize);
+      for (size_t i = 0; i < left_count; ++i) {
+        offsets_l[num_l] = static_cast<unsigned char>(i);
+        num_l += static_cast<size_t>(!(*first < pivot));
+        ++first;
+      }
+      const size_t right_count = std::min(right_split, kBlockSize);
+      for (size_t i = 1; i <= right_count; ++i) {
+        offsets_r[num_r] = static_cast<unsigned char>(i);
+        num_r += static_cast<size_t>(*--last < pivot);
+      }
+
+      const size_t count = std::min(num_l, num_r);
+      swapOffsets(left_base, right_base, offsets_l + start_l,
+                  offsets_r + start_r, count, num_l == num_r);
+      num_l -= count;
+      num_r -= count;
+      start_l += count;
+      start_r += count;
+      if (num_l == 0) {
+        start_l = 0;
+        left_base = first;
+      }
+      if (num_r == 0) {
+        start_r = 0;
+        right_base = last;
+      }
+    }
+
+    // At most one block still holds misplaced elements; move them to the
+    // boundary.
+    if (num_l > 0) {
+      while (num_l-- > 0) {
+        std::swap(*(left_base + offsets_l[start_l + num_l]), *--last);
+      }
+      first = last;
+    }
+    if (num_r > 0) {
+      while (num_r-- > 0) {
+        std::swap(*(right_base - offsets_r[start_r + num_r]), *first);
+        ++first;
+      }
+      last = first;
+    }
+  }
+
+  T* pivot_pos = first - 1;
+  *begin = std::move(*pivot_pos);
+  *pivot_pos = std::move(pivot);
+  return {pivot_pos, already_partitioned};
+}
+
+// Partitions into elements <= pivot and elements > pivot and returns the
+// pivot's position. Used when *(begin - 1) equals the pivot, so everything on
+// the left is equal to it and already in place.
+template <typename T>
+T* partitionLeft(T* begin, T* end) {
+  T pivot = std::move(*begin);
+  T* first = begin;
+  T* last = end;
+
+  while (pivot < *--last) {
+  }
+  if (last + 1 == end) {
+    while (first < last && !(pivot < *++first)) {
+    }
+  } else {
+    while (!(pivot < *++first)) {
+    }
+  }
+
+  while (first < last) {
+    std::swap(*first, *last);
+    while (pivot < *--last) {
+    }
+    while (!(pivot < *++first)) {
+    }
+  }
+
+  T* pivot_pos = last;
+  *begin = std::move(*pivot_pos);
+  *pivot_pos = std::move(pivot);
+  return pivot_pos;
+}
+
+// Swaps a few elements near both ends of a range to break up the pattern
+// behind an unbalanced partition.
+template <typename T>
+void shuffleEnds(T* begin, T* end) {
+  const size_t size = static_cast<size_t>(end - begin);
+  if (size < kInsertionSortThreshold) return;
+  const size_t quarter = size / 4;
+  std::swap(*begin, *(begin + quarter));
+  std::swap(*(end - 1), *(end - quarter));
+  if (size > kNintherThreshold) {
+    std::swap(*(begin + 1), *(begin + (quarter + 1)));
+    std::swap(*(begin + 2), *(begin + (quarter + 2)));
+    std::swap(*(end - 2), *(end - (quarter + 1)));
+    std::swap(*(end - 3), *(end - (quarter + 2)));
+  }
+}
+
+template <typename T, bool Branchless>
+void pdqsortLoop(T* begin, T* end, size_t bad_allowed, bool leftmost) {
+  while (true) {
+    const size_t size = static_cast<size_t>(end - begin);
+    if (size < kInsertionSortThreshold) {
+      if (leftmost) {
+        insertion_sort(std::span<T>(begin, end));
+      } else {
+        unguardedInsertionSort(begin, end);
+      }
+      return;
+    }
+
+    choosePivot(begin, end);
+
+    // Nothing in the range is smaller than *(begin - 1). If the pivot is not
+    // greater either, every element equal to it belongs here and is done.
+    if (!leftmost && !(*(begin - 1) < *begin)) {
+      begin = partitionLeft(begin, end) + 1;
+      continue;
+    }
+
+    const PartitionResult<T> result = Branchless
+                                          ? partitionRightBranchless(begin, end)
+                                          : partitionRight(begin, end);
+    T* pivot = result.pivot;
+    const size_t left_size = static_cast<size_t>(pivot - begin);
+    const size_t right_size = static_cast<size_t>(end - (pivot + 1));
+
+    if (left_size < size / 8 || right_size < size / 8) {
+      if (--bad_allowed == 0) {
+        heap_sort(std::span<T>(begin, end));
+        return;
+      }
+      shuffleEnds(begin, pivot);
+      shuffleEnds(pivot + 1, end);
+    } else if (result.already_partitioned &&
+               partialInsertionSort(begin, pivot) &&
+               partialInsertionSort(pivot + 1, end)) {
+      // A balanced split that moved nothing suggests sorted input; a cheap
+      // insertion sort that does not have to move much confirms it.
+      return;
+    }
+
+    // The bad-partition budget keeps recursion depth logarithmic, so it is
+    // fine to always recurse left and loop on the right.
+    pdqsortLoop<T, Branchless>(begin, pivot, bad_allowed, leftmost);
+    begin = pivot + 1;
+    leftmost = false;
+  }
+}
+
+// Handles spans that are entirely sorted or strictly descending in one pass.
+// The scan stops at the first element that breaks the run, so on other
+// inputs it costs a few comparisons.
+template <typename T>
+bool sortedOrReversed(std::span<T> arr) {
+  size_t i = 1;
+  while (i < arr.size() && !(arr[i] < arr[i - 1])) ++i;
+  if (i == arr.size()) return true;
+  if (i > 1) return false;
+  while (i < arr.size() && arr[i] < arr[i - 1]) ++i;
+  if (i < arr.size()) return false;
+  std::ranges::reverse(arr);
+  return true;
+}
+
+}  // namespace pdq_detail
+
+template <Sortable T>
+void pdq_sort(std::span<T> arr) {
+  if (arr.size() < 2 || pdq_detail::sortedOrReversed(arr)) return;
+  const size_t bad_allowed = static_cast<size_t>(std::bit_width(arr.size()));
+  T* begin = arr.data();
+  T* end = begin + arr.size();
+  pdq_detail::pdqsortLoop<T, std::is_arithmetic_v<T>>(begin, end, bad_allowed,
+                                                      true);
+}
+
+template <SortableRange Range>
+void pdq_sort(Range&& range) {
+  pdq_sort(std::span{std::forward<Range>(range)});
+}
@@ -0,0 +1,149 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <concepts>
+#include <cstddef>
+#include <ranges>
+#include <span>
+#include <stdexcept>
+#include <utility>
+
+#include "small_sort.h"
+
+template <typename T>
+concept Sortable = std::totally_ordered<T> && std::movable<T>;
+
+template <typename Range>
+concept SortableRange = std::ranges::random_access_range<Range> &&
+                        Sortable<std::ranges::range_value_t<Range>>;
+
+// Spans at or below this size are finished with insertion sort, which beats
+// partitioning on a handful of elements.
+inline constexpr size_t kInsertionSortThreshold = 24;
+
+// Where small_sort's branch-free networks are available, they take over
+// larger spans than insertion sort does.
+template <typename T>
+inline constexpr size_t kBaseCaseThreshold =
+    SimdSortable<T> && kHasSimdSmallSort ? kSmallSortMaxSize
+                                         : kInsertionSortThreshold;
+
+template <typename T>
+[[nodiscard]] constexpr T medianOfThreePivot(std::span<T> arr) {
+  if (arr.size() < 2) {
+    throw std::invalid_argument("span size must be at least 2");
+  }
+
+  size_t low = 0;
+  size_t high = arr.size() - 1;
+  size_t mid = high / 2;
+
+  // Sort the three elements at low, mid, and high
+  if (arr[mid] < arr[low]) std::swap(arr[mid], arr[low]);
+  if (arr[high] < arr[low]) std::swap(arr[high], arr[low]);
+  if (arr[high] < arr[mid]) std::swap(arr[high], arr[mid]);
+
+  // Place the median just before the last element as the pivot
+  std::swap(arr[mid], arr[high - 1]);
+
+  return arr[high - 1];  // Return the pivot value
+}
+
+template <Sortable T>
+[[nodiscard]] constexpr size_t partition(std::span<T> arr) {
+  if (arr.size() <= 2) return 0;
+
+  T pivot = medianOfThreePivot(arr);
+  size_t low = 0;
+  size_t high = arr.size() - 1;
+
+  // arr[low] <= pivot <= arr[high] after the median of three, so both scans
+  // stop before running off the ends
+  size_t i = low;
+  size_t j = high - 1;
+
+  while (true) {
+    while (arr[++i] < pivot) {
+    }
+    while (pivot < arr[--j]) {
+    }
+    if (i >= j) break;
+    std::swap(arr[i], arr[j]);
+  }
+
+  // Move the pivot between the two halves
+  std::swap(arr[i], arr[high - 1]);
+
+  return i;
+}
+
+// Shifts each element left into place through a hole, one move per step.
+template <Sortable T>
+constexpr void insertion_sort(std::span<T> arr) {
+  for (size_t i = 1; i < arr.size(); ++i) {
+    if (!(arr[i] < arr[i - 1])) continue;
+    T value = std::move(arr[i]);
+    size_t j = i;
+    do {
+      arr[j] = std::move(arr[j - 1]);
+      --j;
+    } while (j > 0 && value < arr[j - 1]);
+    arr[j] = std::move(value);
+  }
+}
+
+template <Sortable T>
+constexpr void sortBaseCase(std::span<T> arr) {
+  if constexpr (SimdSortable<T> && kHasSimdSmallSort) {
+    if !consteval {
+      small_sort(arr);
+      return;
+    }
+  }
+  insertion_sort(arr);
+}
+
+template <Sortable T>
+constexpr void heap_sort(std::span<T> arr) {
+  std::ranges::make_heap(arr);
+  std::ranges::sort_heap(arr);
+}
+
+// Introsort: quicksort that recurses only into the smaller side and loops on
+// the larger one, so the stack stays O(log n). Once depth_limit partitions
+// have not shrunk the input enough, the remaining span is heapsorted, which
+// caps the worst case at O(n log n).
+template <Sortable T>
+constexpr void introsort(std::span<T> arr, size_t depth_limit) {
+  while (arr.size() > kBaseCaseThreshold<T>) {
+    if (depth_limit == 0) {
+      heap_sort(arr);
+      return;
+    }
+    --depth_limit;
+
+    const size_t p = partition(arr);
+    std::span<T> left = arr.first(p);
+    std::span<T> right = arr.subspan(p + 1);
+    if (left.size() < right.size()) {
+      introsort(left, depth_limit);
+      arr = right;
+    } else {
+      introsort(right, depth_limit);
+      arr = left;
+    }
+  }
+  sortBaseCase(arr);
+}
+
+template <Sortable T>
+constexpr void quick_sort(std::span<T> arr) {
+  if (arr.size() < 2) return;
+  introsort(arr, 2 * static_cast<size_t>(std::bit_width(arr.size())));
+}
+
+template <SortableRange Range>
+constexpr void quick_sort(Range&& range) {
+  quick_sort(std::span{std::forward<Range>(range)});
+}
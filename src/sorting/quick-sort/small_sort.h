@@ -0,0 +1,198 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <type_traits>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+// Sorting networks for small arrays of int32 or float, in AVX2 registers.
+//
+// Each 8-lane vector is sorted with a bitonic network: six compare-exchange
+// steps, each a lane permutation, a min, a max and a blend. Sorted vectors
+// are merged with the same network across registers. The sequence of
+// operations is fixed, so there are no data-dependent branches to
+// mispredict, unlike insertion sort, which usually mispredicts about once
+// per element. Without AVX2 the same functions fall back to std::sort.
+template <typename T>
+concept SimdSortable = std::same_as<T, int32_t> || std::same_as<T, float>;
+
+// Sizes with a fixed network; smaller spans are padded to the next one.
+template <size_t N>
+concept SmallSortSize = N == 8 || N == 16 || N == 32 || N == 64;
+
+inline constexpr size_t kSmallSortMaxSize = 64;
+
+#if defined(__AVX2__)
+inline constexpr bool kHasSimdSmallSort = true;
+
+namespace small_sort_detail {
+
+template <typename T>
+struct Lanes;
+
+template <>
+struct Lanes<int32_t> {
+  using Vector = __m256i;
+  static Vector load(const int32_t* p) {
+    return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+  }
+  static void store(int32_t* p, Vector v) {
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(p), v);
+  }
+  static Vector min(Vector a, Vector b) { return _mm256_min_epi32(a, b); }
+  static Vector max(Vector a, Vector b) { return _mm256_max_epi32(a, b); }
+  static Vector permute(Vector v, __m256i index) {
+    return _mm256_permutevar8x32_epi32(v, index);
+  }
+  template <int Mask>
+  static Vector blend(Vector a, Vector b) {
+    return _mm256_blend_epi32(a, b, Mask);
+  }
+};
+
+template <>
+struct Lanes<float> {
+  using Vector = __m256;
+  static Vector load(const float* p) { return _mm256_loadu_ps(p); }
+  static void store(float* p, Vector v) { _mm256_storeu_ps(p, v); }
+  static Vector min(Vector a, Vector b) { return _mm256_min_ps(a, b); }
+  static Vector max(Vector a, Vector b) { return _mm256_max_ps(a, b); }
+  static Vector permute(Vector v, __m256i index) {
+    return _mm256_permutevar8x32_ps(v, index);
+  }
+  template <int Mask>
+  static Vector blend(Vector a, Vector b) {
+    return _mm256_blend_ps(a, b, Mask);
+  }
+};
+
+// Compares every lane with lane Partner[i]; lanes whose bit is set in
+// MaxLanes keep the larger value, the others the smaller.
+//
+// The float min and max return their second operand when the inputs compare
+// equal, so a compare-exchange must pass the operands to max in the opposite
+// order from min. Otherwise -0.0 and +0.0 both come out as the same zero.
+// Here the partner lane does that naturally.
+template <typename T, int P0, int P1, int P2, int P3, int P4, int P5, int P6,
+          int P7, int MaxLanes>
+typename Lanes<T>::Vector exchange(typename Lanes<T>::Vector v) {
+  using L = Lanes<T>;
+  const auto partner =
+      L::permute(v, _mm256_setr_epi32(P0, P1, P2, P3, P4, P5, P6, P7));
+  return L::template blend<MaxLanes>(L::min(v, partner), L::max(v, partner));
+}
+
+template <typename T>
+typename Lanes<T>::Vector reverse(typename Lanes<T>::Vector v) {
+  return Lanes<T>::permute(v, _mm256_setr_epi32(7, 6, 5, 4, 3, 2, 1, 0));
+}
+
+// Finishes a merge inside one vector whose halves are already split at
+// distance 4: half-cleaners at distances 4, 2 and 1.
+template <typename T>
+typename Lanes<T>::Vector cleanVector(typename Lanes<T>::Vector v) {
+  v = exchange<T, 4, 5, 6, 7, 0, 1, 2, 3, 0b11110000>(v);
+  v = exchange<T, 2, 3, 0, 1, 6, 7, 4, 5, 0b11001100>(v);
+  return exchange<T, 1, 0, 3, 2, 5, 4, 7, 6, 0b10101010>(v);
+}
+
+// Bitonic sort of the 8 lanes. Each merge starts with a "flip" step that
+// compares lane i with its mirror in the group, so every stage sorts
+// ascending and no lanes need reversing.
+template <typename T>
+typename Lanes<T>::Vector sortVector(typename Lanes<T>::Vector v) {
+  v = exchange<T, 1, 0, 3, 2, 5, 4, 7, 6, 0b10101010>(v);
+  v = exchange<T, 3, 2, 1, 0, 7, 6, 5, 4, 0b11001100>(v);
+  v = exchange<T, 1, 0, 3, 2, 5, 4, 7, 6, 0b10101010>(v);
+  v = exchange<T, 7, 6, 5, 4, 3, 2, 1, 0, 0b11110000>(v);
+  v = exchange<T, 2, 3, 0, 1, 6, 7, 4, 5, 0b11001100>(v);
+  return exchange<T, 1, 0, 3, 2, 5, 4, 7, 6, 0b10101010>(v);
+}
+
+// Sorts Count vectors, viewed as one sequence of 8 * Count elements.
+template <typename T, size_t Count>
+void sortVectors(typename Lanes<T>::Vector (&v)[Count]) {
+  using L = Lanes<T>;
+  for (auto& vector : v) vector = sortVector<T>(vector);
+
+  for (size_t group = 2; group <= Count; group *= 2) {
+    for (size_t first = 0; first < Count; first += group) {
+      // Flip: element p meets element group * 8 - 1 - p, which sits in the
+      // mirrored vector at the mirrored lane.
+      for (size_t i = 0; i < group / 2; ++i) {
+        auto& low = v[first + i];
+        auto& high = v[first + group - 1 - i];
+        const auto mirrored = reverse<T>(high);
+        high = reverse<T>(L::max(mirrored, low));
+        low = L::min(low, mirrored);
+      }
+      // Half-cleaners across whole vectors, then inside each vector.
+      for (size_t distance = group / 4; distance > 0; distance /= 2) {
+        for (size_t i = first; i < first + group; ++i) {
+          if ((i - first) & distance) continue;
+          const auto low = L::min(v[i], v[i + distance]);
+          v[i + distance] = L::max(v[i + distance], v[i]);
+          v[i] = low;
+        }
+      }
+    }
+    for (auto& vector : v) vector = cleanVector<T>(vector);
+  }
+}
+
+}  // namespace small_sort_detail
+
+template <size_t N, SimdSortable T>
+  requires SmallSortSize<N>
+void small_sort(std::span<T, N> arr) {
+  using L = small_sort_detail::Lanes<T>;
+  constexpr size_t kVectors = N / 8;
+  // A plain array: std::array would drop the vector type's alignment.
+  typename L::Vector v[kVectors];
+  for (size_t i = 0; i < kVectors; ++i) v[i] = L::load(arr.data() + 8 * i);
+  small_sort_detail::sortVectors<T, kVectors>(v);
+  for (size_t i = 0; i < kVectors; ++i) L::store(arr.data() + 8 * i, v[i]);
+}
+#else
+inline constexpr bool kHasSimdSmallSort = false;
+
+template <size_t N, SimdSortable T>
+  requires SmallSortSize<N>
+void small_sort(std::span<T, N> arr) {
+  std::ranges::sort(arr);
+}
+#endif
+
+// Sorts up to kSmallSortMaxSize elements by padding them with the largest
+// value to the next network size; longer spans go to std::sort.
+template <SimdSortable T>
+void small_sort(std::span<T> arr) {
+  const auto sortPadded = [arr]<size_t N>() {
+    std::array<T, N> padded;
+    const auto tail = std::ranges::copy(arr, padded.begin()).out;
+    std::fill(tail, padded.end(), std::numeric_limits<T>::has_infinity
+                                      ? std::numeric_limits<T>::infinity()
+                                      : std::numeric_limits<T>::max());
+    small_sort<N>(std::span<T, N>(padded));
+    std::copy_n(padded.begin(), arr.size(), arr.begin());
+  };
+  if (arr.size() <= 1) return;
+  if (arr.size() <= 8) {
+    sortPadded.template operator()<8>();
+  } else if (arr.size() <= 16) {
+    sortPadded.template operator()<16>();
+  } else if (arr.size() <= 32) {
+    sortPadded.template operator()<32>();
+  } else if (arr.size() <= kSmallSortMaxSize) {
+    sortPadded.template operator()<64>();
+  } else {
+    std::ranges::sort(arr);
+  }
+}
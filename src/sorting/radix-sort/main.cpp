@@ -0,0 +1,105 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <print>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "pdq_sort.h"
+#include "radix_sort.h"
+
+template <typename T, typename Sort>
+double timeSort(const std::vector<T>& input, Sort sort) {
+  std::vector<T> values = input;
+  auto start = std::chrono::high_resolution_clock::now();
+  sort(values);
+  auto end = std::chrono::high_resolution_clock::now();
+  if (!std::ranges::is_sorted(values)) std::println("NOT SORTED");
+  return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+template <typename T>
+void compare(const char* name, const std::vector<T>& input) {
+  const double radix = timeSort(input, [](auto& v) { radix_sort(v); });
+  const double pdq = timeSort(input, [](auto& v) { pdq_sort(v); });
+  const double standard =
+      timeSort(input, [](auto& v) { std::ranges::sort(v); });
+  std::println("{:<28}{:>10.1f}{:>10.1f}{:>12.1f}{:>9.1f}x", name, radix, pdq,
+               standard, standard / radix);
+}
+
+void benchmarkRadixSort() {
+  constexpr size_t kSize = 10'000'000;
+  std::mt19937_64 rng(42);
+
+  std::vector<uint64_t> ids(kSize);
+  for (auto& id : ids) id = rng();
+  // Ids below 2^40 leave three of the eight bytes the same in every key.
+  std::vector<uint64_t> small_ids(kSize);
+  for (auto& id : small_ids) id = rng() >> 24;
+  std::vector<int32_t> ints(kSize);
+  for (auto& value : ints) value = static_cast<int32_t>(rng());
+  std::vector<double> doubles(kSize);
+  std::normal_distribution<double> normal(0.0, 1000.0);
+  for (auto& value : doubles) value = normal(rng);
+
+  std::println("Sorting {} keys (ms)", kSize);
+  std::println("{:<28}{:>10}{:>10}{:>12}{:>10}", "keys", "radix", "pdq",
+               "std::sort", "speedup");
+  compare("uint64 ids", ids);
+  compare("uint64 ids below 2^40", small_ids);
+  compare("int32", ints);
+  compare("double, normal", doubles);
+
+  const double parallel =
+      timeSort(ids, [](auto& v) { parallel_radix_sort(v); });
+  std::println("{:<28}{:>10.1f}", "uint64 ids, parallel radix", parallel);
+}
+
+void benchmarkStrings() {
+  constexpr size_t kSize = 1'000'000;
+  std::mt19937_64 rng(7);
+  std::uniform_int_distribution<int> letter('a', 'z');
+  std::vector<std::string> words(kSize);
+  for (auto& word : words) {
+    // A shared prefix, as in URLs or file paths, costs a comparison sort on
+    // every comparison but MSD radix sort only once.
+    word = "https://example.com/";
+    const size_t length = 4 + rng() % 12;
+    for (size_t i = 0; i < length; ++i) {
+      word.push_back(static_cast<char>(letter(rng)));
+    }
+  }
+
+  std::println("\nSorting {} strings (ms)", kSize);
+  compare("URLs", words);
+}
+
+void demoArgsort() {
+  const std::vector<float> scores = {0.5f, -1.25f, 3.0f, -0.0f, 0.0f, 2.5f};
+  const auto order = argsort<float>(scores);
+  std::print("\nargsort of scores: ");
+  for (size_t index : order) std::print("{} ", index);
+  std::print("\nscores in order:   ");
+  for (size_t index : order) std::print("{} ", scores[index]);
+  std::println("");
+
+  std::vector<uint32_t> keys = {30, 10, 20, 10};
+  std::vector<std::string> names = {"thirty", "ten", "twenty", "another ten"};
+  radix_sort_by_key(std::span(keys), std::span(names));
+  std::print("by key:            ");
+  for (size_t i = 0; i < keys.size(); ++i) {
+    std::print("{}={} ", keys[i], names[i]);
+  }
+  std::println("");
+}
+
+int main() {
+  benchmarkRadixSort();
+  benchmarkStrings();
+  demoArgsort();
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,328 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <barrier>
+#include <bit>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <ranges>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Keys that radix sort handles by their bit pattern.
+template <typename T>
+concept RadixKey =
+    (std::integral<T> && !std::same_as<T, bool>) ||
+    (std::floating_point<T> && (sizeof(T) == 4 || sizeof(T) == 8));
+
+template <typename Range>
+concept RadixSortableRange =
+    std::ranges::contiguous_range<Range> &&
+    (RadixKey<std::ranges::range_value_t<Range>> ||
+     std::same_as<std::ranges::range_value_t<Range>, std::string>);
+
+namespace radix_detail {
+
+inline constexpr size_t kDigitBits = 8;
+inline constexpr size_t kBuckets = size_t{1} << kDigitBits;
+
+template <typename T>
+using UnsignedKey =
+    std::conditional_t<sizeof(T) == 1, uint8_t,
+                       std::conditional_t<sizeof(T) == 2, uint16_t,
+                                          std::conditional_t<sizeof(T) == 4,
+                                                             uint32_t,
+                                                             uint64_t>>>;
+
+template <typename T>
+inline constexpr size_t kDigits = sizeof(T) * 8 / kDigitBits;
+
+// Maps a key to an unsigned integer with the same order. Signed integers get
+// their sign bit flipped. IEEE floats are sign-magnitude: positive values
+// order like their bits once the sign bit is set, and negative values need
+// all bits flipped so that larger magnitudes come first. NaNs with the sign
+// bit clear sort after +infinity, and -0.0 sorts before +0.0.
+template <RadixKey T>
+constexpr UnsignedKey<T> toKey(T value) {
+  using U = UnsignedKey<T>;
+  constexpr U kSignBit = U{1} << (sizeof(T) * 8 - 1);
+  if constexpr (std::floating_point<T>) {
+    const U bits = std::bit_cast<U>(value);
+    return (bits & kSignBit) ? static_cast<U>(~bits)
+                             : static_cast<U>(bits | kSignBit);
+  } else if constexpr (std::signed_integral<T>) {
+    return static_cast<U>(static_cast<U>(value) ^ kSignBit);
+  } else {
+    return static_cast<U>(value);
+  }
+}
+
+template <RadixKey T>
+constexpr size_t digitOf(T value, size_t digit) {
+  return static_cast<size_t>(toKey(value) >> (digit * kDigitBits)) &
+         (kBuckets - 1);
+}
+
+template <RadixKey T>
+using Histograms = std::array<std::array<size_t, kBuckets>, kDigits<T>>;
+
+// Counts every digit in one pass over the keys, so later passes only move
+// data.
+template <RadixKey T>
+Histograms<T> histogram(std::span<const T> keys) {
+  Histograms<T> counts{};
+  for (const T& key : keys) {
+    const auto bits = toKey(key);
+    for (size_t d = 0; d < kDigits<T>; ++d) {
+      ++counts[d][static_cast<size_t>(bits >> (d * kDigitBits)) &
+                  (kBuckets - 1)];
+    }
+  }
+  return counts;
+}
+
+// A digit that is the same in every key leaves the order unchanged, e.g. the
+// high bytes of 64-bit ids that fit in 32 bits.
+inline bool allEqual(const std::array<size_t, kBuckets>& counts,
+                     size_t total) {
+  return std::ranges::any_of(counts,
+                             [total](size_t count) { return count == total; });
+}
+
+// Turns counts into starting offsets.
+inline void exclusiveScan(std::array<size_t, kBuckets>& counts) {
+  size_t sum = 0;
+  for (size_t& count : counts) sum += std::exchange(count, sum);
+}
+
+// Stable LSD passes over keys, dragging values (if any) along. Ends with the
+// result in keys and values.
+template <RadixKey T, typename V>
+void lsdSort(std::span<T> keys, std::span<V> values) {
+  constexpr bool kHasValues = !std::is_same_v<V, std::nullptr_t>;
+  const size_t n = keys.size();
+  Histograms<T> counts = histogram<T>(keys);
+
+  std::vector<T> key_buffer(n);
+  std::vector<V> value_buffer(kHasValues ? n : 0);
+  std::span<T> key_from = keys;
+  std::span<T> key_to = key_buffer;
+  std::span<V> value_from = values;
+  std::span<V> value_to = value_buffer;
+
+  for (size_t d = 0; d < kDigits<T>; ++d) {
+    if (allEqual(counts[d], n)) continue;
+    exclusiveScan(counts[d]);
+    auto& offsets = counts[d];
+    for (size_t i = 0; i < n; ++i) {
+      const size_t slot = offsets[digitOf(key_from[i], d)]++;
+      key_to[slot] = key_from[i];
+      if constexpr (kHasValues) value_to[slot] = std::move(value_from[i]);
+    }
+    std::swap(key_from, key_to);
+    if constexpr (kHasValues) std::swap(value_from, value_to);
+  }
+
+  // After an odd number of passes the result sits in the buffers.
+  if (key_from.data() != keys.data()) {
+    std::ranges::copy(key_from, keys.begin());
+    if constexpr (kHasValues) std::ranges::move(value_from, values.begin());
+  }
+}
+
+inline constexpr size_t kStringSmallBucket = 32;
+// One bucket per byte value plus one, in front, for strings that end here.
+inline constexpr size_t kStringBuckets = kBuckets + 1;
+
+inline size_t stringBucket(const std::string& s, size_t depth) {
+  return depth < s.size()
+             ? static_cast<size_t>(static_cast<unsigned char>(s[depth])) + 1
+             : 0;
+}
+
+// MSD: distribute by the byte at depth, then recurse into every bucket with
+// the next byte. Strings that ended form bucket 0 and are all equal. Small
+// buckets are left to a comparison sort that skips the shared prefix.
+inline void msdSort(std::span<std::string> arr, std::span<std::string> buffer,
+                    size_t depth) {
+  std::array<size_t, kStringBuckets + 1> offsets{};
+  while (true) {
+    if (arr.size() <= kStringSmallBucket) {
+      std::ranges::sort(arr, [depth](const std::string& a,
+                                     const std::string& b) {
+        return std::string_view(a).substr(std::min(depth, a.size())) <
+               std::string_view(b).substr(std::min(depth, b.size()));
+      });
+      return;
+    }
+
+    offsets.fill(0);
+    for (const std::string& s : arr) ++offsets[stringBucket(s, depth) + 1];
+    // A byte shared by all strings needs no distribution pass; long common
+    // prefixes are walked here instead of by recursion.
+    const auto shared = std::ranges::find(offsets, arr.size());
+    if (shared == offsets.end()) break;
+    if (shared == offsets.begin() + 1) return;  // all strings ended
+    ++depth;
+  }
+
+  for (size_t b = 1; b <= kStringBuckets; ++b) offsets[b] += offsets[b - 1];
+  std::array<size_t, kStringBuckets> next{};
+  std::copy_n(offsets.begin(), kStringBuckets, next.begin());
+  for (std::string& s : arr) {
+    buffer[next[stringBucket(s, depth)]++] = std::move(s);
+  }
+  std::ranges::move(buffer.first(arr.size()), arr.begin());
+
+  for (size_t b = 1; b < kStringBuckets; ++b) {
+    const size_t size = offsets[b + 1] - offsets[b];
+    if (size > 1) {
+      msdSort(arr.subspan(offsets[b], size), buffer, depth + 1);
+    }
+  }
+}
+
+}  // namespace radix_detail
+
+// LSD radix sort on 8-bit digits: a histogram pre-pass counts all digits at
+// once, and each remaining pass is a stable scatter. Digits that are the same
+// in every key are skipped. O(n · sizeof(T)) time and O(n) extra space.
+template <RadixKey T>
+void radix_sort(std::span<T> keys) {
+  if (keys.size() < 2) return;
+  radix_detail::lsdSort(keys, std::span<std::nullptr_t>());
+}
+
+// Sorts keys and applies the same permutation to values. Stable: equal keys
+// keep their values in the original order.
+template <RadixKey K, typename V>
+  requires std::movable<V> && std::default_initializable<V>
+void radix_sort_by_key(std::span<K> keys, std::span<V> values) {
+  if (keys.size() != values.size()) {
+    throw std::invalid_argument("keys and values must have the same size");
+  }
+  if (keys.size() < 2) return;
+  radix_detail::lsdSort(keys, values);
+}
+
+// Returns the indices that put keys in ascending order, without moving keys.
+template <RadixKey K>
+std::vector<size_t> argsort(std::span<const K> keys) {
+  std::vector<K> sorted(keys.begin(), keys.end());
+  std::vector<size_t> indices(keys.size());
+  for (size_t i = 0; i < indices.size(); ++i) indices[i] = i;
+  radix_sort_by_key(std::span<K>(sorted), std::span<size_t>(indices));
+  return indices;
+}
+
+// MSD radix sort for strings in byte-wise (std::string operator<) order.
+inline void radix_sort(std::span<std::string> arr) {
+  if (arr.size() < 2) return;
+  std::vector<std::string> buffer(arr.size());
+  radix_detail::msdSort(arr, buffer, 0);
+}
+
+// LSD radix sort with each pass split across threads. Every thread counts the
+// digit in its own chunk; the per-thread histograms give each (bucket,
+// thread) pair its own output range, so the scatter needs no
+// synchronization and stays stable. Threads meet at a barrier between
+// counting and scattering.
+template <RadixKey T>
+void parallel_radix_sort(std::span<T> keys, size_t threads = 0) {
+  using namespace radix_detail;
+  constexpr size_t kMinElementsPerThread = 1 << 16;
+
+  if (threads == 0) {
+    threads = std::max(1u, std::thread::hardware_concurrency());
+  }
+  threads = std::min(threads, keys.size() / kMinElementsPerThread);
+  if (threads <= 1) {
+    radix_sort(keys);
+    return;
+  }
+
+  // The totals per digit do not depend on the order, so which digits can be
+  // skipped is known before the first pass.
+  const size_t n = keys.size();
+  std::vector<Histograms<T>> partial(threads);
+  {
+    std::vector<std::jthread> workers;
+    for (size_t t = 0; t < threads; ++t) {
+      workers.emplace_back([&, t] {
+        partial[t] = histogram<T>(keys.subspan(n * t / threads,
+                                               n * (t + 1) / threads -
+                                                   n * t / threads));
+      });
+    }
+  }
+  std::vector<size_t> passes;
+  for (size_t d = 0; d < kDigits<T>; ++d) {
+    std::array<size_t, kBuckets> total{};
+    for (const auto& counts : partial) {
+      for (size_t b = 0; b < kBuckets; ++b) total[b] += counts[d][b];
+    }
+    if (!allEqual(total, n)) passes.push_back(d);
+  }
+
+  std::vector<T> buffer(n);
+  std::span<T> from = keys;
+  std::span<T> to = buffer;
+  std::vector<std::array<size_t, kBuckets>> offsets(threads);
+  // The barrier's completion step runs on one thread while the others wait.
+  // After counting it turns the counts into offsets, in bucket-major,
+  // thread-minor order so the scatter stays stable; after scattering it
+  // swaps the buffers.
+  bool counted = false;
+  auto step = [&]() noexcept {
+    if (!counted) {
+      size_t sum = 0;
+      for (size_t b = 0; b < kBuckets; ++b) {
+        for (auto& counts : offsets) sum += std::exchange(counts[b], sum);
+      }
+    } else {
+      std::swap(from, to);
+    }
+    counted = !counted;
+  };
+  std::barrier sync(static_cast<std::ptrdiff_t>(threads), step);
+
+  std::vector<std::jthread> workers;
+  for (size_t t = 0; t < threads; ++t) {
+    workers.emplace_back([&, t] {
+      const size_t begin = n * t / threads;
+      const size_t end = n * (t + 1) / threads;
+      auto& mine = offsets[t];
+      for (size_t d : passes) {
+        mine.fill(0);
+        for (size_t i = begin; i < end; ++i) ++mine[digitOf(from[i], d)];
+        sync.arrive_and_wait();
+        for (size_t i = begin; i < end; ++i) {
+          to[mine[digitOf(from[i], d)]++] = from[i];
+        }
+        sync.arrive_and_wait();
+      }
+    });
+  }
+  workers.clear();
+
+  if (from.data() != keys.data()) std::ranges::copy(from, keys.begin());
+}
+
+template <RadixSortableRange Range>
+void radix_sort(Range&& range) {
+  radix_sort(std::span{std::forward<Range>(range)});
+}
+
+template <RadixSortableRange Range>
+  requires RadixKey<std::ranges::range_value_t<Range>>
+void parallel_radix_sort(Range&& range, size_t threads = 0) {
+  parallel_radix_sort(std::span{std::forward<Range>(range)}, threads);
+}